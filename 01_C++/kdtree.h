@@ -0,0 +1,174 @@
+#pragma once
+
+#include <algorithm>
+#include <bit>
+#include <cstdint>
+#include <future>
+#include <thread>
+#include <vector>
+#include "point.h"
+
+//////////////////////////////////////////////////////////////////////////////////////////////
+// Static k-d tree over a copy of a point set.
+// The points are reordered such that every subtree covers a contiguous range of m_points.
+// Subtrees whose bounding box lies inside a query box are therefore copied as a whole
+// without testing single points.
+class KdTree {
+	struct Node {
+		Point lo, hi;		// bounding box of the subtree
+		uint32_t begin, end;	// range in m_points
+		int32_t left, right;	// child nodes, -1 in leaves
+	};
+
+	static constexpr uint32_t LeafSize = 32;
+
+	std::vector<Point> m_points;
+	std::vector<Node> m_nodes;
+
+	static bool contains(const Point& from, const Point& to, const Node& n) {
+		return from <= n.lo && n.hi <= to;
+	}
+
+	static bool disjoint(const Point& from, const Point& to, const Node& n) {
+		return !(from <= n.hi && n.lo <= to);
+	}
+
+	// number of nodes of a subtree over count points
+	static uint32_t nodeCount(uint32_t count) {
+		return (count <= LeafSize) ? 1 : 1 + nodeCount(count/2) + nodeCount(count - count/2);
+	}
+
+	// builds the subtree over m_points[begin..end) into m_nodes[id..]
+	// the top levels are built concurrently, node ids are known in advance
+	void build(int32_t id, uint32_t begin, uint32_t end, int parallelDepth) {
+		float lo[3] = { m_points[begin][0], m_points[begin][1], m_points[begin][2] };
+		float hi[3] = { lo[0], lo[1], lo[2] };
+
+		for (uint32_t i = begin + 1; i < end; i++) {
+			for (int d = 0; d < 3; d++) {
+				lo[d] = std::min(lo[d], m_points[i][d]);
+				hi[d] = std::max(hi[d], m_points[i][d]);
+			}
+		}
+		m_nodes[id] = { { lo[0], lo[1], lo[2] }, { hi[0], hi[1], hi[2] }, begin, end, -1, -1 };
+
+		if (end - begin > LeafSize) {
+			// split at the median of the widest dimension
+			int d = 0;
+			for (int k = 1; k < 3; k++) {
+				if (hi[k] - lo[k] > hi[d] - lo[d]) d = k;
+			}
+
+			const uint32_t mid = begin + (end - begin)/2;
+			std::nth_element(m_points.begin() + begin, m_points.begin() + mid, m_points.begin() + end, [d](const Point& a, const Point& b) {
+				return a[d] < b[d];
+			});
+
+			const int32_t left = id + 1;
+			const int32_t right = left + (int32_t)nodeCount(mid - begin);
+
+			m_nodes[id].left = left;
+			m_nodes[id].right = right;
+			if (parallelDepth > 0) {
+				auto f = std::async(std::launch::async, [=, this] { build(left, begin, mid, parallelDepth - 1); });
+				build(right, mid, end, parallelDepth - 1);
+				f.get();
+			} else {
+				build(left, begin, mid, 0);
+				build(right, mid, end, 0);
+			}
+		}
+	}
+
+	template<typename F>
+	void query(int32_t id, const Point& from, const Point& to, F& f) const {
+		const Node& n = m_nodes[id];
+
+		if (disjoint(from, to, n)) return;
+		if (contains(from, to, n)) {
+			f(m_points.data() + n.begin, m_points.data() + n.end);
+		} else if (n.left < 0) {
+			for (uint32_t i = n.begin; i < n.end; i++) {
+				const Point& p = m_points[i];
+				if (from <= p && p <= to) f(&p, &p + 1);
+			}
+		} else {
+			query(n.left, from, to, f);
+			query(n.right, from, to, f);
+		}
+	}
+
+	// squared distance from q to the bounding box of n
+	static float distance2(const Point& q, const Node& n) {
+		float d2 = 0;
+
+		for (int d = 0; d < 3; d++) {
+			const float delta = std::max({ n.lo[d] - q[d], 0.0f, q[d] - n.hi[d] });
+			d2 += delta*delta;
+		}
+		return d2;
+	}
+
+	void knn(int32_t id, const Point& q, KnnHeap& heap) const {
+		const Node& n = m_nodes[id];
+
+		if (n.left < 0) {
+			for (uint32_t i = n.begin; i < n.end; i++) {
+				const float d2 = ::distance2(q, m_points[i]);
+				if (d2 <= heap.bound()) heap.push(d2, m_points[i]);
+			}
+		} else {
+			// visit the closer child first, the farther one only if it can still contribute
+			const float dl = distance2(q, m_nodes[n.left]);
+			const float dr = distance2(q, m_nodes[n.right]);
+			const int32_t first = (dl <= dr) ? n.left : n.right;
+			const int32_t second = (dl <= dr) ? n.right : n.left;
+
+			knn(first, q, heap);
+			if (std::max(dl, dr) <= heap.bound()) knn(second, q, heap);
+		}
+	}
+
+public:
+	explicit KdTree(const std::vector<Point>& v) : m_points(v) {
+		if (!m_points.empty()) {
+			const unsigned nThreads = std::max(1u, std::thread::hardware_concurrency());
+
+			m_nodes.resize(nodeCount((uint32_t)m_points.size()));
+			build(0, 0, (uint32_t)m_points.size(), std::bit_width(nThreads - 1));
+		}
+	}
+
+	size_t size() const {
+		return m_points.size();
+	}
+
+	//////////////////////////////////////////////////////////////////////////////////////////////
+	// calls f(first, last) for contiguous runs [first, last) of points inside the box [from, to]
+	template<typename F>
+	void forEachInBox(const Point& from, const Point& to, F f) const {
+		if (!m_nodes.empty()) query(0, from, to, f);
+	}
+
+	//////////////////////////////////////////////////////////////////////////////////////////////
+	// returns all points inside the box [from, to]; expected is used to pre-size the result
+	std::vector<Point> rangeQuery(const Point& from, const Point& to, size_t expected = 0) const {
+		std::vector<Point> result;
+
+		result.reserve(expected);
+		forEachInBox(from, to, [&result](const Point* first, const Point* last) {
+			result.insert(result.end(), first, last);
+		});
+		return result;
+	}
+
+	//////////////////////////////////////////////////////////////////////////////////////////////
+	// exact k nearest neighbours of q in ascending order of distance
+	// the same tree serves range queries and kNN queries
+	std::vector<Neighbor> knn(const Point& q, size_t k) const {
+		KnnHeap heap(k);
+
+		if (k > 0 && !m_nodes.empty()) knn(0, q, heap);
+		return heap.extract();
+	}
+};
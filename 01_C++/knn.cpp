@@ -0,0 +1,123 @@
+#include <algorithm>
+#include <iostream>
+#include <iomanip>
+#include <vector>
+#include <thread>
+#include <random>
+#include "Stopwatch.h"
+#include "point.h"
+#include "rangescan.h"
+#include "kdtree.h"
+
+//////////////////////////////////////////////////////////////////////////////////////////////
+// Brute-force k nearest neighbours (baseline)
+// The distances of a block of points are computed in a unit-stride loop over the SoA arrays,
+// which vectorizes. Only distances not above the current k-th distance are collected as
+// candidates; whenever the candidate buffer grows large, a partial selection (nth_element)
+// keeps the k best and tightens the bound.
+static std::vector<Neighbor> knnBruteForce(const PointsSoA& s, const Point& q, size_t k) {
+	constexpr size_t Block = 4096;
+	const float qx = q[0], qy = q[1], qz = q[2];
+	const float* x = s.x.data();
+	const float* y = s.y.data();
+	const float* z = s.z.data();
+	std::vector<float> d2(Block);
+	std::vector<Neighbor> cand;
+	float bound = std::numeric_limits<float>::infinity();
+
+	if (k == 0) return cand;
+	cand.reserve(4*k + Block);
+
+	auto select = [&cand, k]() {
+		if (cand.size() > k) {
+			std::nth_element(cand.begin(), cand.begin() + (k - 1), cand.end());
+			cand.resize(k);
+		}
+	};
+
+	for (size_t base = 0; base < s.size(); base += Block) {
+		const size_t cnt = std::min(Block, s.size() - base);
+
+		for (size_t i = 0; i < cnt; i++) {
+			const float dx = x[base + i] - qx;
+			const float dy = y[base + i] - qy;
+			const float dz = z[base + i] - qz;
+
+			d2[i] = dx*dx + dy*dy + dz*dz;
+		}
+		for (size_t i = 0; i < cnt; i++) {
+			if (d2[i] <= bound) cand.push_back({ d2[i], s[base + i] });
+		}
+		if (cand.size() >= 4*k) {
+			select();
+			bound = cand[k - 1].dist2;
+		}
+	}
+	select();
+	std::sort(cand.begin(), cand.end());
+	return cand;
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////
+// Batch of kNN queries spread over all hardware threads
+template<typename F>
+static std::vector<std::vector<Neighbor>> knnBatch(const std::vector<Point>& queries, F query) {
+	std::vector<std::vector<Neighbor>> results(queries.size());
+
+	parallelChunks(queries.size(), 1, [&](size_t, size_t begin, size_t end) {
+		for (size_t i = begin; i < end; i++) results[i] = query(queries[i]);
+	});
+	return results;
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////
+// Print throughput
+static void report(const char text[], size_t queries, double t, bool same) {
+	std::cout << std::setw(30) << std::left << text << queries << " queries";
+	std::cout << " in " << std::right << std::setw(8) << std::setprecision(2) << std::fixed << t << " ms, " << queries*1000/t << " queries/s" << std::endl;
+	std::cout << std::boolalpha << "The two operations produce the same results: " << same << std::endl << std::endl;
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////
+// kNN throughput of the k-d tree and of the brute-force scan for different k and data sizes
+void knnTests() {
+	std::cout << "\nk-Nearest-Neighbour Tests" << std::endl;
+
+	constexpr size_t Queries = 10'000;
+	constexpr size_t BruteForceQueries = 16;
+
+	for (int n : { 1'000'000, 10'000'000 }) {
+		std::default_random_engine e;
+		Stopwatch sw;
+		const std::vector<Point> points = randomPoints(n, e);
+		const std::vector<Point> queries = randomPoints(Queries, e);
+
+		const std::vector<Point> bfQueries(queries.begin(), queries.begin() + BruteForceQueries);
+		const PointsSoA soa(points);
+
+		std::cout << "\nn = " << n << std::endl;
+		sw.Start();
+		const KdTree index(points);
+		sw.Stop();
+		std::cout << "k-d tree built in " << sw.GetElapsedTimeMilliseconds() << " ms" << std::endl;
+
+		// the same index answers range queries
+		const Point from(0.4f, 0.4f, 0.4f), to(0.5f, 0.5f, 0.5f);
+		std::cout << "range query on the shared index: " << index.rangeQuery(from, to).size() << " hits" << std::endl << std::endl;
+
+		for (size_t k : { 1, 10, 100 }) {
+			std::cout << "k = " << k << std::endl;
+
+			sw.Restart();
+			const auto resultBF = knnBatch(bfQueries, [&](const Point& q) { return knnBruteForce(soa, q, k); });
+			sw.Stop();
+			report("Brute force (SIMD):", bfQueries.size(), sw.GetElapsedTimeMilliseconds(), true);
+
+			sw.Restart();
+			const auto resultKd = knnBatch(queries, [&](const Point& q) { return index.knn(q, k); });
+			sw.Stop();
+			const bool same = std::equal(resultBF.begin(), resultBF.end(), resultKd.begin());
+			report("k-d tree:", queries.size(), sw.GetElapsedTimeMilliseconds(), same);
+		}
+	}
+}
@@ -0,0 +1,121 @@
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <iostream>
+#include <iomanip>
+#include <vector>
+#include <thread>
+#include <random>
+#include "Stopwatch.h"
+#include "point.h"
+#include "rangescan.h"
+
+//////////////////////////////////////////////////////////////////////////////////////////////
+// Aggregation over materialized points
+static PointSum sum(const std::vector<Point>& v) {
+	PointSum total;
+
+	for (const Point& p : v) total += { p[0], p[1], p[2] };
+	return total;
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////
+// Sums of different modes are added in different orders, hence compared with a tolerance
+static bool same(const PointSum& a, const PointSum& b) {
+	auto eq = [](double u, double v) { return std::abs(u - v) <= 1e-9*std::max(1.0, std::abs(u)); };
+
+	return eq(a.x, b.x) && eq(a.y, b.y) && eq(a.z, b.z);
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////
+// Print the timings of one result mode
+static void report(const char text[], size_t bytes, double tFilter, double tCount, double tSum, double tGather, bool ok) {
+	constexpr double MB = 1024*1024;
+
+	std::cout << std::setw(30) << std::left << text << std::right << std::setprecision(2) << std::fixed;
+	std::cout << "result " << std::setw(8) << bytes/MB << " MB, filter " << std::setw(7) << tFilter << " ms, count " << std::setw(6) << tCount;
+	std::cout << " ms, sum " << std::setw(7) << tSum << " ms, gather " << std::setw(7) << tGather << " ms" << std::endl;
+	std::cout << std::boolalpha << "The two operations produce the same results: " << ok << std::endl << std::endl;
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////
+// Materialized results against selection vectors and bitmaps consumed by count, sum and gather
+void lateMaterializationTests() {
+	std::cout << "\nLate Materialization Tests" << std::endl;
+
+	constexpr int N = 10'000'000;
+
+	std::default_random_engine e;
+	std::uniform_real_distribution<float> dist;
+	Stopwatch sw;
+	std::vector<Point> points = randomPoints(N, e);
+
+	const PointsSoA soa(points);
+
+	for (float side : { 0.05f, 0.2f, 0.5f, 0.9f }) {
+		const Point from(dist(e)*(1 - side), dist(e)*(1 - side), dist(e)*(1 - side));
+		const Point to = from + Point(side, side, side);
+
+		std::cout << "\nbox side = " << side << std::endl;
+
+		sw.Restart();
+		std::vector<Point> resultS = rqSerial(points, from, to);
+		sw.Stop();
+		const double ts = sw.GetElapsedTimeMilliseconds();
+		const PointSum sumS = sum(resultS);
+		report("Sequential (materialized):", resultS.size()*sizeof(Point), ts, 0, 0, 0, true);
+
+		// materialized: every hit is copied before any operator runs
+		sw.Restart();
+		std::vector<Point> resultM = scanAoS(points, from, to, resultS.size());
+		sw.Stop();
+		const double tFilterM = sw.GetElapsedTimeMilliseconds();
+		sw.Restart();
+		const size_t countM = resultM.size();
+		sw.Stop();
+		const double tCountM = sw.GetElapsedTimeMilliseconds();
+		sw.Restart();
+		const PointSum sumM = sum(resultM);
+		sw.Stop();
+		const double tSumM = sw.GetElapsedTimeMilliseconds();
+		report("Parallel materialized:", resultM.size()*sizeof(Point), tFilterM, tCountM, tSumM, 0, countM == resultS.size() && same(sumS, sumM));
+
+		// bitmap: one bit per input point, count by popcount
+		sw.Restart();
+		const Bitmap bm = scanBitmap(soa, from, to);
+		sw.Stop();
+		const double tFilterB = sw.GetElapsedTimeMilliseconds();
+		sw.Restart();
+		const size_t countB = bm.count();
+		sw.Stop();
+		const double tCountB = sw.GetElapsedTimeMilliseconds();
+		sw.Restart();
+		const PointSum sumB = sum(soa, bm);
+		sw.Stop();
+		const double tSumB = sw.GetElapsedTimeMilliseconds();
+		sw.Restart();
+		std::vector<Point> resultB = gather(points, bm);
+		sw.Stop();
+		const double tGatherB = sw.GetElapsedTimeMilliseconds();
+		report("Bitmap:", bm.words()*sizeof(uint64_t), tFilterB, tCountB, tSumB, tGatherB, countB == resultS.size() && same(sumS, sumB) && resultB == resultS);
+
+		// selection vector: one 32-bit index per hit
+		sw.Restart();
+		const Selection sel = scanSelection(soa, from, to);
+		sw.Stop();
+		const double tFilterSel = sw.GetElapsedTimeMilliseconds();
+		sw.Restart();
+		const size_t countSel = sel.size();
+		sw.Stop();
+		const double tCountSel = sw.GetElapsedTimeMilliseconds();
+		sw.Restart();
+		const PointSum sumSel = sum(soa, sel);
+		sw.Stop();
+		const double tSumSel = sw.GetElapsedTimeMilliseconds();
+		sw.Restart();
+		std::vector<Point> resultSel = gather(points, sel);
+		sw.Stop();
+		const double tGatherSel = sw.GetElapsedTimeMilliseconds();
+		report("Selection vector:", sel.size()*sizeof(uint32_t), tFilterSel, tCountSel, tSumSel, tGatherSel, countSel == resultS.size() && same(sumS, sumSel) && resultSel == resultS);
+	}
+}
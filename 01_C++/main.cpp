@@ -10,8 +10,38 @@ void findMaximumTests();
 // this function is implemented in rangequery.cpp
 void rangeQueryTests();
 
+//////////////////////////////////////////////////////////////////////////////////////////////
+// this function is implemented in queryplanner.cpp
+void queryPlannerTests();
+
+//////////////////////////////////////////////////////////////////////////////////////////////
+// this function is implemented in quantizedpoints.cpp
+void quantizedPointsTests();
+
+//////////////////////////////////////////////////////////////////////////////////////////////
+// this function is implemented in knn.cpp
+void knnTests();
+
+//////////////////////////////////////////////////////////////////////////////////////////////
+// this function is implemented in snapshotstore.cpp
+void snapshotStoreTests();
+
+//////////////////////////////////////////////////////////////////////////////////////////////
+// this function is implemented in zonemaps.cpp
+void zoneMapTests();
+
+//////////////////////////////////////////////////////////////////////////////////////////////
+// this function is implemented in latematerialization.cpp
+void lateMaterializationTests();
+
 int main() {
 	summationTests();
 	findMaximumTests();
 	rangeQueryTests();
+	queryPlannerTests();
+	quantizedPointsTests();
+	knnTests();
+	snapshotStoreTests();
+	zoneMapTests();
+	lateMaterializationTests();
 }
@@ -0,0 +1,129 @@
+#pragma once
+
+#include <algorithm>
+#include <iostream>
+#include <limits>
+#include <vector>
+
+//////////////////////////////////////////////////////////////////////////////////////////////
+// 3D point used by the range query tests
+class Point {
+	float x, y, z;
+
+public:
+	Point() = default;
+	Point(float a, float b, float c) : x(a), y(b), z(c) {}
+
+	bool operator==(const Point& p) const {
+		return x == p.x && y == p.y && z == p.z;
+	}
+
+	bool operator<(const Point& p) const {
+		return std::lexicographical_compare(&x, &x + 3, &p.x, &p.x + 3);
+	}
+
+	bool operator<=(const Point& p) const {
+		return x <= p.x && y <= p.y && z <= p.z;
+	}
+
+	Point operator+(const Point& p) const {
+		return { x + p.x, y + p.y, z + p.z };
+	}
+
+	// coordinate d (0 = x, 1 = y, 2 = z)
+	float operator[](int d) const {
+		return (&x)[d];
+	}
+
+	friend std::ostream& operator<<(std::ostream& os, const Point& p) {
+		return os << '(' << p.x << ',' << p.y << ',' << p.z << ')';
+	}
+};
+
+//////////////////////////////////////////////////////////////////////////////////////////////
+// squared Euclidean distance
+inline float distance2(const Point& a, const Point& b) {
+	const float dx = a[0] - b[0];
+	const float dy = a[1] - b[1];
+	const float dz = a[2] - b[2];
+
+	return dx*dx + dy*dy + dz*dz;
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////
+// Result entry of a k-nearest-neighbour query, ordered by distance
+struct Neighbor {
+	float dist2;
+	Point p;
+
+	bool operator==(const Neighbor& n) const {
+		return dist2 == n.dist2 && p == n.p;
+	}
+
+	bool operator<(const Neighbor& n) const {
+		return dist2 < n.dist2 || (dist2 == n.dist2 && p < n.p);
+	}
+};
+
+//////////////////////////////////////////////////////////////////////////////////////////////
+// Bounded max-heap keeping the k nearest neighbours seen so far
+class KnnHeap {
+	std::vector<Neighbor> m_heap;
+	size_t m_k;
+
+public:
+	explicit KnnHeap(size_t k) : m_k(k) {
+		m_heap.reserve(k);
+	}
+
+	bool full() const {
+		return m_heap.size() == m_k;
+	}
+
+	// distance of the current k-th neighbour, infinite as long as the heap isn't full
+	float bound() const {
+		return full() ? m_heap.front().dist2 : std::numeric_limits<float>::infinity();
+	}
+
+	void push(float dist2, const Point& p) {
+		if (!full()) {
+			m_heap.push_back({ dist2, p });
+			std::push_heap(m_heap.begin(), m_heap.end());
+		} else if (Neighbor{ dist2, p } < m_heap.front()) {
+			std::pop_heap(m_heap.begin(), m_heap.end());
+			m_heap.back() = { dist2, p };
+			std::push_heap(m_heap.begin(), m_heap.end());
+		}
+	}
+
+	// neighbours in ascending order of distance, the heap is empty afterwards
+	std::vector<Neighbor> extract() {
+		std::sort_heap(m_heap.begin(), m_heap.end());
+		return std::move(m_heap);
+	}
+};
+
+//////////////////////////////////////////////////////////////////////////////////////////////
+// Structure of arrays copy of a point set: one contiguous array per coordinate.
+// Filters over this layout touch only unit-stride float arrays and vectorize.
+struct PointsSoA {
+	std::vector<float> x, y, z;
+
+	PointsSoA() = default;
+
+	explicit PointsSoA(const std::vector<Point>& v) : x(v.size()), y(v.size()), z(v.size()) {
+		for (size_t i = 0; i < v.size(); i++) {
+			x[i] = v[i][0];
+			y[i] = v[i][1];
+			z[i] = v[i][2];
+		}
+	}
+
+	size_t size() const {
+		return x.size();
+	}
+
+	Point operator[](size_t i) const {
+		return { x[i], y[i], z[i] };
+	}
+};
@@ -0,0 +1,228 @@
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <iostream>
+#include <iomanip>
+#include <vector>
+#include <thread>
+#include <random>
+#ifdef __AVX2__
+#include <immintrin.h>
+#endif
+#include "Stopwatch.h"
+#include "point.h"
+#include "rangescan.h"
+
+//////////////////////////////////////////////////////////////////////////////////////////////
+// Compressed point store for range queries.
+// Every coordinate is quantized to a 16-bit fixed-point value, so the first filter pass reads
+// 6 instead of 12 bytes per point. The quantization is monotone, hence for a query box [from, to]
+// - q(p) strictly between q(from) and q(to) in all dimensions: p is inside the box
+// - q(p) outside [q(from), q(to)] in any dimension: p is outside the box
+// - otherwise p lies in a boundary cell and is re-checked against the full-precision point.
+// The full-precision points are kept in a separate array that is only touched for hits.
+// The quantized coordinates are stored as structure of arrays, so the filter vectorizes.
+class QuantizedPoints {
+	std::vector<uint16_t> m_quantized[3];	// one array per coordinate, 6 bytes per point
+	std::vector<Point> m_full;
+	double m_lo[3];
+	double m_scale[3];
+
+	// monotone non-decreasing in v
+	uint16_t quantize(int d, float v) const {
+		const double t = std::floor(((double)v - m_lo[d])*m_scale[d]);
+		return (uint16_t)std::clamp(t, 0.0, 65535.0);
+	}
+
+public:
+	struct Stats {
+		size_t candidates = 0;	// points in boundary cells
+		size_t bytes = 0;	// bytes read by the filter, without materialization
+	};
+
+	explicit QuantizedPoints(const std::vector<Point>& v) : m_full(v) {
+		for (int d = 0; d < 3; d++) {
+			float lo = v.empty() ? 0 : v[0][d];
+			float hi = lo;
+
+			for (const Point& p : v) {
+				lo = std::min(lo, p[d]);
+				hi = std::max(hi, p[d]);
+			}
+			m_lo[d] = lo;
+			m_scale[d] = (hi > lo) ? 65536.0/((double)hi - (double)lo) : 0;
+			m_quantized[d].resize(v.size());
+			for (size_t i = 0; i < v.size(); i++) m_quantized[d][i] = quantize(d, v[i][d]);
+		}
+	}
+
+	size_t size() const {
+		return m_full.size();
+	}
+
+	// bitmap of the points inside the box [from, to]
+	Bitmap filter(const Point& from, const Point& to, Stats& stats) const {
+		const size_t nThreads = std::max(1u, std::thread::hardware_concurrency());
+		const uint16_t qlo[3] = { quantize(0, from[0]), quantize(1, from[1]), quantize(2, from[2]) };
+		const uint16_t qhi[3] = { quantize(0, to[0]), quantize(1, to[1]), quantize(2, to[2]) };
+		uint16_t qlo1[3], qhi1[3];	// bounds of the strictly inner cells, empty if qlo1 > qhi1
+		std::vector<size_t> candidates(nThreads);
+		Bitmap bm(m_full.size());
+
+		for (int d = 0; d < 3; d++) {
+			const bool empty = qlo[d] == 65535 || qhi[d] == 0;
+
+			qlo1[d] = empty ? 65535 : qlo[d] + 1;
+			qhi1[d] = empty ? 0 : qhi[d] - 1;
+		}
+#ifdef __AVX2__
+		__m256i vlo[3], vhi[3], vlo1[3], vhi1[3];
+
+		for (int d = 0; d < 3; d++) {
+			vlo[d] = _mm256_set1_epi16((short)qlo[d]);
+			vhi[d] = _mm256_set1_epi16((short)qhi[d]);
+			vlo1[d] = _mm256_set1_epi16((short)qlo1[d]);
+			vhi1[d] = _mm256_set1_epi16((short)qhi1[d]);
+		}
+#endif
+
+		parallelChunks(m_full.size(), 64, [&](size_t c, size_t begin, size_t end) {
+			const uint16_t* q[3] = { m_quantized[0].data(), m_quantized[1].data(), m_quantized[2].data() };
+			uint64_t* words = bm.data();
+			size_t refined = 0;
+
+			for (size_t base = begin; base < end; base += 64) {
+				const size_t cnt = std::min<size_t>(64, end - base);
+				uint64_t candBits = 0, insideBits = 0;
+				size_t i = 0;
+
+#ifdef __AVX2__
+				// 32 points per iteration: unsigned 16-bit range tests with min/max, packed to a bit mask
+				for (; i + 32 <= cnt; i += 32) {
+					__m256i cand[2], inside[2];
+
+					for (int h = 0; h < 2; h++) {
+						cand[h] = inside[h] = _mm256_set1_epi16(-1);
+						for (int d = 0; d < 3; d++) {
+							const __m256i v = _mm256_loadu_si256((const __m256i*)(q[d] + base + i + 16*h));
+
+							cand[h] = _mm256_and_si256(cand[h], _mm256_and_si256(_mm256_cmpeq_epi16(_mm256_max_epu16(v, vlo[d]), v), _mm256_cmpeq_epi16(_mm256_min_epu16(v, vhi[d]), v)));
+							inside[h] = _mm256_and_si256(inside[h], _mm256_and_si256(_mm256_cmpeq_epi16(_mm256_max_epu16(v, vlo1[d]), v), _mm256_cmpeq_epi16(_mm256_min_epu16(v, vhi1[d]), v)));
+						}
+					}
+					const __m256i c8 = _mm256_permute4x64_epi64(_mm256_packs_epi16(cand[0], cand[1]), 0xD8);
+					const __m256i i8 = _mm256_permute4x64_epi64(_mm256_packs_epi16(inside[0], inside[1]), 0xD8);
+
+					candBits |= (uint64_t)(uint32_t)_mm256_movemask_epi8(c8) << i;
+					insideBits |= (uint64_t)(uint32_t)_mm256_movemask_epi8(i8) << i;
+				}
+#endif
+				// branch-free classification of the remaining points
+				for (; i < cnt; i++) {
+					const size_t k = base + i;
+					const uint64_t cand = (qlo[0] <= q[0][k]) & (q[0][k] <= qhi[0]) & (qlo[1] <= q[1][k]) & (q[1][k] <= qhi[1]) & (qlo[2] <= q[2][k]) & (q[2][k] <= qhi[2]);
+					const uint64_t inside = (qlo1[0] <= q[0][k]) & (q[0][k] <= qhi1[0]) & (qlo1[1] <= q[1][k]) & (q[1][k] <= qhi1[1]) & (qlo1[2] <= q[2][k]) & (q[2][k] <= qhi1[2]);
+
+					candBits |= cand << i;
+					insideBits |= inside << i;
+				}
+
+				// refine boundary points against the full-precision coordinates
+				uint64_t boundary = candBits & ~insideBits;
+				while (boundary) {
+					const int b = std::countr_zero(boundary);
+					const Point& p = m_full[base + b];
+
+					refined++;
+					if (from <= p && p <= to) insideBits |= uint64_t(1) << b;
+					boundary &= boundary - 1;
+				}
+				words[base >> 6] = insideBits;
+			}
+			candidates[c] = refined;
+		});
+
+		stats.candidates = 0;
+		for (size_t c : candidates) stats.candidates += c;
+		stats.bytes = m_full.size()*3*sizeof(uint16_t) + stats.candidates*sizeof(Point);
+		return bm;
+	}
+
+	// points inside the box [from, to], materialized from the full-precision array
+	std::vector<Point> rangeQuery(const Point& from, const Point& to, Stats& stats) const {
+		return gather(m_full, filter(from, to, stats));
+	}
+};
+
+//////////////////////////////////////////////////////////////////////////////////////////////
+// Quantized first-pass filter against the full-precision AoS and SoA scans
+void quantizedPointsTests() {
+	std::cout << "\nQuantized Point Tests" << std::endl;
+
+	constexpr int N = 10'000'000;
+	constexpr double MB = 1024*1024;
+
+	std::default_random_engine e;
+	std::uniform_real_distribution<float> dist;
+	Stopwatch sw;
+	std::vector<Point> points = randomPoints(N, e);
+
+	const PointsSoA soa(points);
+
+	sw.Start();
+	const QuantizedPoints quantized(points);
+	sw.Stop();
+	std::cout << "quantized store built in " << sw.GetElapsedTimeMilliseconds() << " ms" << std::endl;
+
+	for (float side : { 0.05f, 0.2f, 0.5f, 0.9f }) {
+		const Point from(dist(e)*(1 - side), dist(e)*(1 - side), dist(e)*(1 - side));
+		const Point to = from + Point(side, side, side);
+
+		std::cout << "\nbox side = " << side << std::endl;
+
+		sw.Restart();
+		std::vector<Point> resultS = rqSerial(points, from, to);
+		sw.Stop();
+		const double ts = sw.GetElapsedTimeMilliseconds();
+		std::sort(resultS.begin(), resultS.end());
+		check("Sequential:", resultS, resultS, ts, ts);
+
+		sw.Restart();
+		std::vector<Point> resultAoS = scanAoS(points, from, to, resultS.size());
+		sw.Stop();
+		const double tAoS = sw.GetElapsedTimeMilliseconds();
+		std::sort(resultAoS.begin(), resultAoS.end());
+		std::cout << "scanned " << N*sizeof(Point)/MB << " MB" << std::endl;
+		check("Float AoS scan:", resultS, resultAoS, ts, tAoS);
+
+		sw.Restart();
+		std::vector<Point> resultSoA = gather(points, scanBitmap(soa, from, to));
+		sw.Stop();
+		const double tSoA = sw.GetElapsedTimeMilliseconds();
+		std::sort(resultSoA.begin(), resultSoA.end());
+		std::cout << "scanned " << N*3*sizeof(float)/MB << " MB" << std::endl;
+		check("Float SoA scan:", resultS, resultSoA, ts, tSoA);
+
+		QuantizedPoints::Stats stats;
+		sw.Restart();
+		std::vector<Point> resultQ = quantized.rangeQuery(from, to, stats);
+		sw.Stop();
+		const double tQ = sw.GetElapsedTimeMilliseconds();
+		std::sort(resultQ.begin(), resultQ.end());
+		std::cout << "scanned " << stats.bytes/MB << " MB, refined " << stats.candidates << " boundary points, ";
+		std::cout << "speedup vs AoS = " << tAoS/tQ << ", vs SoA = " << tSoA/tQ << std::endl;
+		check("Quantized 16-bit scan:", resultS, resultQ, ts, tQ);
+
+		// filter pass only, without materialization
+		sw.Restart();
+		const size_t hitsSoA = scanBitmap(soa, from, to).count();
+		sw.Stop();
+		const double tFilterSoA = sw.GetElapsedTimeMilliseconds();
+		sw.Restart();
+		const size_t hitsQ = quantized.filter(from, to, stats).count();
+		sw.Stop();
+		const double tFilterQ = sw.GetElapsedTimeMilliseconds();
+		std::cout << "filter only: float SoA " << tFilterSoA << " ms, quantized " << tFilterQ << " ms, speedup = " << tFilterSoA/tFilterQ;
+		std::cout << std::boolalpha << ", same hits: " << (hitsSoA == hitsQ) << std::endl;
+	}
+}
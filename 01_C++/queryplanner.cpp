@@ -0,0 +1,220 @@
+#include <algorithm>
+#include <limits>
+#include <iostream>
+#include <iomanip>
+#include <vector>
+#include <thread>
+#include <random>
+#include "Stopwatch.h"
+#include "point.h"
+#include "rangescan.h"
+#include "kdtree.h"
+
+//////////////////////////////////////////////////////////////////////////////////////////////
+// Execution strategies of a range query
+enum class Plan { Scan, SimdBitmap, Index };
+
+static const char* planName(Plan plan) {
+	switch (plan) {
+	case Plan::Scan: return "scan";
+	case Plan::SimdBitmap: return "SIMD scan + bitmap";
+	default: return "index lookup";
+	}
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////
+// Selectivity-aware range query planner.
+// A reservoir sample drawn once over the points estimates the number of hits of a query box.
+// Every plan has a linear cost model t = fixed + perHit*hits, calibrated once by running the
+// plan on a small and on a full box. The planner executes the plan with the smallest predicted
+// time and pre-sizes the output buffer with the estimate.
+class QueryPlanner {
+	struct Cost {
+		double fixed;	// ms per query
+		double perHit;	// ms per hit
+	};
+
+	const std::vector<Point>& m_points;
+	const PointsSoA& m_soa;
+	const KdTree* m_index;	// optional
+	std::vector<Point> m_sample;
+	Cost m_cost[3];		// indexed by Plan
+
+	static constexpr float SmallBoxSide = 0.02f;	// side of the small calibration box relative to the sample extent
+
+	double predict(Plan plan, size_t hits) const {
+		const Cost& c = m_cost[(int)plan];
+		return c.fixed + c.perHit*hits;
+	}
+
+	void calibrate() {
+		const float inf = std::numeric_limits<float>::infinity();
+		float lo[3] = { inf, inf, inf }, hi[3] = { -inf, -inf, -inf };
+		float from[3], to[3];
+
+		for (const Point& p : m_sample) {
+			for (int d = 0; d < 3; d++) {
+				lo[d] = std::min(lo[d], p[d]);
+				hi[d] = std::max(hi[d], p[d]);
+			}
+		}
+
+		// small box around the center of the sample (SmallBoxSide of its extent per dimension),
+		// full box covering all points
+		for (int d = 0; d < 3; d++) {
+			if (lo[d] > hi[d]) lo[d] = hi[d] = 0;	// empty sample
+
+			const float center = lo[d] + (hi[d] - lo[d])/2;
+			const float half = SmallBoxSide*(hi[d] - lo[d])/2;
+
+			from[d] = center - half;
+			to[d] = center + half;
+		}
+
+		const Point smallFrom(from[0], from[1], from[2]), smallTo(to[0], to[1], to[2]);
+		const Point fullFrom(-inf, -inf, -inf), fullTo(inf, inf, inf);
+		Stopwatch sw;
+
+		for (Plan plan : { Plan::Scan, Plan::SimdBitmap, Plan::Index }) {
+			if (plan == Plan::Index && !m_index) continue;
+
+			sw.Restart();
+			const size_t h0 = execute(plan, smallFrom, smallTo, 0).size();
+			sw.Stop();
+			const double t0 = sw.GetElapsedTimeMilliseconds();
+
+			sw.Restart();
+			const size_t h1 = execute(plan, fullFrom, fullTo, m_points.size()).size();
+			sw.Stop();
+			const double t1 = sw.GetElapsedTimeMilliseconds();
+
+			const double perHit = (h1 > h0) ? std::max(0.0, (t1 - t0)/(h1 - h0)) : 0;
+			m_cost[(int)plan] = { std::max(0.0, t0 - perHit*h0), perHit };
+		}
+	}
+
+public:
+	static constexpr size_t SampleSize = 1 << 14;
+
+	QueryPlanner(const std::vector<Point>& v, const PointsSoA& soa, const KdTree* index)
+		: m_points(v)
+		, m_soa(soa)
+		, m_index(index)
+		, m_cost{}
+	{
+		// reservoir sampling (algorithm R)
+		std::default_random_engine e(42);
+		const size_t s = std::min(SampleSize, v.size());
+
+		m_sample.assign(v.begin(), v.begin() + s);
+		for (size_t i = s; i < v.size(); i++) {
+			const size_t j = std::uniform_int_distribution<size_t>(0, i)(e);
+			if (j < s) m_sample[j] = v[i];
+		}
+		calibrate();
+	}
+
+	// estimated number of points inside the box [from, to]
+	size_t estimate(const Point& from, const Point& to) const {
+		if (m_sample.empty()) return 0;
+
+		const size_t hits = std::count_if(m_sample.begin(), m_sample.end(), [&](const Point& p) {
+			return from <= p && p <= to;
+		});
+		return (size_t)((double)hits*m_points.size()/m_sample.size() + 0.5);
+	}
+
+	// plan with the smallest predicted time
+	Plan choose(size_t estimated) const {
+		Plan best = (predict(Plan::Scan, estimated) < predict(Plan::SimdBitmap, estimated)) ? Plan::Scan : Plan::SimdBitmap;
+
+		if (m_index && predict(Plan::Index, estimated) < predict(best, estimated)) best = Plan::Index;
+		return best;
+	}
+
+	std::vector<Point> execute(Plan plan, const Point& from, const Point& to, size_t estimated) const {
+		// over-allocate the estimate a little, the sample error is about sqrt(hits)
+		const size_t expected = estimated + estimated/8 + 64;
+
+		switch (plan) {
+		case Plan::Index: return m_index->rangeQuery(from, to, expected);
+		case Plan::Scan: return scanAoS(m_points, from, to, expected);
+		default: return gather(m_points, scanBitmap(m_soa, from, to));
+		}
+	}
+
+	// plans and executes a range query and logs the chosen plan
+	std::vector<Point> query(const Point& from, const Point& to) const {
+		const size_t estimated = estimate(from, to);
+		const Plan plan = choose(estimated);
+		std::vector<Point> result = execute(plan, from, to, estimated);
+
+		std::cout << "plan: " << planName(plan) << " (predicted " << predict(plan, estimated) << " ms), estimated hits: " << estimated << ", actual hits: " << result.size() << std::endl;
+		return result;
+	}
+};
+
+//////////////////////////////////////////////////////////////////////////////////////////////
+// Range queries of different selectivity: all strategies against the planner's choice
+void queryPlannerTests() {
+	std::cout << "\nQuery Planner Tests" << std::endl;
+
+	constexpr int N = 10'000'000;
+
+	std::default_random_engine e;
+	std::uniform_real_distribution<float> dist;
+	Stopwatch sw;
+	std::vector<Point> points = randomPoints(N, e);
+
+	sw.Start();
+	const PointsSoA soa(points);
+	sw.Stop();
+	std::cout << "SoA copy built in " << sw.GetElapsedTimeMilliseconds() << " ms" << std::endl;
+
+	sw.Restart();
+	const KdTree index(points);
+	sw.Stop();
+	std::cout << "k-d tree built in " << sw.GetElapsedTimeMilliseconds() << " ms" << std::endl;
+
+	sw.Restart();
+	const QueryPlanner planner(points, soa, &index);
+	const QueryPlanner scanPlanner(points, soa, nullptr);
+	sw.Stop();
+	std::cout << "samples drawn and cost models calibrated in " << sw.GetElapsedTimeMilliseconds() << " ms" << std::endl;
+
+	for (float side : { 0.01f, 0.05f, 0.2f, 0.4f, 0.6f, 0.9f }) {
+		const Point from(dist(e)*(1 - side), dist(e)*(1 - side), dist(e)*(1 - side));
+		const Point to = from + Point(side, side, side);
+
+		std::cout << "\nbox side = " << side << std::endl;
+
+		sw.Restart();
+		std::vector<Point> resultS = rqSerial(points, from, to);
+		sw.Stop();
+		const double ts = sw.GetElapsedTimeMilliseconds();
+		std::sort(resultS.begin(), resultS.end());
+		check("Sequential:", resultS, resultS, ts, ts);
+
+		const size_t estimated = planner.estimate(from, to);
+
+		for (Plan plan : { Plan::Scan, Plan::SimdBitmap, Plan::Index }) {
+			sw.Restart();
+			std::vector<Point> result = planner.execute(plan, from, to, estimated);
+			sw.Stop();
+			std::sort(result.begin(), result.end());
+			check(planName(plan), resultS, result, ts, sw.GetElapsedTimeMilliseconds());
+		}
+
+		sw.Restart();
+		std::vector<Point> result = planner.query(from, to);
+		sw.Stop();
+		std::sort(result.begin(), result.end());
+		check("Planned query:", resultS, result, ts, sw.GetElapsedTimeMilliseconds());
+
+		sw.Restart();
+		result = scanPlanner.query(from, to);
+		sw.Stop();
+		std::sort(result.begin(), result.end());
+		check("Planned query (no index):", resultS, result, ts, sw.GetElapsedTimeMilliseconds());
+	}
+}
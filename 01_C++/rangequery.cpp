@@ -9,33 +9,7 @@
 #include <future>
 #include <random>
 #include "Stopwatch.h"
-
-class Point {
-	float x, y, z;
-
-public:
-	Point(float a, float b, float c) : x(a), y(b), z(c) {}
-
-	bool operator==(const Point& p) const {
-		return x == p.x && y == p.y && z == p.z;
-	}
-
-	bool operator<(const Point& p) const {
-		return std::lexicographical_compare(&x, &x + 3, &p.x, &p.x + 3);
-	}
-
-	bool operator<=(const Point& p) const {
-		return x <= p.x && y <= p.y && z <= p.z;
-	}
-
-	Point operator+(const Point& p) const {
-		return { x + p.x, y + p.y, z + p.z };
-	}
-
-	friend std::ostream& operator<<(std::ostream& os, const Point& p) {
-		return os << '(' << p.x << ',' << p.y << ',' << p.z << ')';
-	}
-};
+#include "point.h"
 
 //////////////////////////////////////////////////////////////////////////////////////////////
 // Sequential range query
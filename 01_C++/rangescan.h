@@ -0,0 +1,297 @@
+#pragma once
+
+#include <algorithm>
+#include <bit>
+#include <cstdint>
+#include <future>
+#include <iomanip>
+#include <iostream>
+#include <iterator>
+#include <random>
+#include <thread>
+#include <vector>
+#ifdef __AVX2__
+#include <immintrin.h>
+#endif
+#include "point.h"
+
+//////////////////////////////////////////////////////////////////////////////////////////////
+// Test fixture: n points uniformly distributed in the unit cube
+inline std::vector<Point> randomPoints(size_t n, std::default_random_engine& e) {
+	std::uniform_real_distribution<float> dist;
+	std::vector<Point> points;
+
+	points.reserve(n);
+	for (size_t i = 0; i < n; i++) points.emplace_back(dist(e), dist(e), dist(e));
+	return points;
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////
+// Sequential range query (reference)
+inline std::vector<Point> rqSerial(const std::vector<Point>& v, const Point& from, const Point& to) {
+	std::vector<Point> result;
+
+	std::copy_if(v.begin(), v.end(), std::back_inserter(result), [&](const Point& p) {
+		return from <= p && p <= to;
+	});
+	return result;
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////
+// Check and print results of a range query: number of hits, time, speedup and efficiency
+template<typename T>
+inline void check(const char text[], const std::vector<T>& ref, const std::vector<T>& result, double ts, double tp) {
+	static const unsigned p = std::thread::hardware_concurrency();
+	const double S = ts/tp;
+	const double E = S/p;
+
+	std::cout << std::setw(30) << std::left << text << result.size();
+	std::cout << " in " << std::right << std::setw(6) << std::setprecision(2) << std::fixed << tp << " ms, S = " << S << ", E = " << E << std::endl;
+	std::cout << std::boolalpha << "The two operations produce the same results: " << (ref == result) << std::endl << std::endl;
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////
+// Packed bitmap over the positions of an input array: bit i is set if element i matches
+class Bitmap {
+	std::vector<uint64_t> m_words;
+	size_t m_size;
+
+public:
+	explicit Bitmap(size_t n = 0) : m_words((n + 63)/64), m_size(n) {}
+
+	size_t size() const { return m_size; }
+	size_t words() const { return m_words.size(); }
+	uint64_t* data() { return m_words.data(); }
+	const uint64_t* data() const { return m_words.data(); }
+
+	bool test(size_t i) const {
+		return (m_words[i >> 6] >> (i & 63)) & 1;
+	}
+
+	void set(size_t i) {
+		m_words[i >> 6] |= uint64_t(1) << (i & 63);
+	}
+
+	// number of set bits in words [wBegin, wEnd)
+	size_t count(size_t wBegin, size_t wEnd) const {
+		size_t c = 0;
+
+		for (size_t w = wBegin; w < wEnd; w++) c += std::popcount(m_words[w]);
+		return c;
+	}
+
+	size_t count() const {
+		return count(0, m_words.size());
+	}
+
+	// calls f(i) for every set bit i in words [wBegin, wEnd) in ascending order
+	template<typename F>
+	void forEach(size_t wBegin, size_t wEnd, F f) const {
+		for (size_t w = wBegin; w < wEnd; w++) {
+			uint64_t bits = m_words[w];
+
+			while (bits) {
+				f((w << 6) + std::countr_zero(bits));
+				bits &= bits - 1;
+			}
+		}
+	}
+
+	template<typename F>
+	void forEach(F f) const {
+		forEach(0, m_words.size(), f);
+	}
+};
+
+//////////////////////////////////////////////////////////////////////////////////////////////
+// Splits [0, n) into one contiguous chunk per hardware thread and runs f(chunk, begin, end)
+// on each chunk concurrently. Chunk boundaries are multiples of align.
+template<typename F>
+inline size_t parallelChunks(size_t n, size_t align, F f) {
+	const size_t nThreads = std::max(1u, std::thread::hardware_concurrency());
+	const size_t chunk = ((n + nThreads - 1)/nThreads + align - 1)/align*align;
+	const size_t nChunks = chunk ? (n + chunk - 1)/chunk : 0;
+	std::vector<std::future<void>> futures;
+
+	futures.reserve(nChunks);
+	for (size_t c = 0; c < nChunks; c++) {
+		futures.push_back(std::async(std::launch::async, f, c, c*chunk, std::min(n, (c + 1)*chunk)));
+	}
+	for (auto& fu : futures) fu.get();
+	return nChunks;
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////
+// Branch-free filter of the points in [begin, end) (begin is a multiple of 64) into bitmap
+// words. With AVX2 eight points are tested per instruction and packed with movemask, otherwise
+// the inner loop has no data dependent branches and is left to the auto-vectorizer.
+inline void scanBitmap(const PointsSoA& s, const Point& from, const Point& to, Bitmap& bm, size_t begin, size_t end) {
+	const float fx = from[0], fy = from[1], fz = from[2];
+	const float tx = to[0], ty = to[1], tz = to[2];
+	const float* x = s.x.data();
+	const float* y = s.y.data();
+	const float* z = s.z.data();
+	uint64_t* words = bm.data();
+#ifdef __AVX2__
+	const __m256 vfx = _mm256_set1_ps(fx), vfy = _mm256_set1_ps(fy), vfz = _mm256_set1_ps(fz);
+	const __m256 vtx = _mm256_set1_ps(tx), vty = _mm256_set1_ps(ty), vtz = _mm256_set1_ps(tz);
+#endif
+
+	for (size_t base = begin; base < end; base += 64) {
+		const size_t cnt = std::min<size_t>(64, end - base);
+		uint64_t bits = 0;
+		size_t i = 0;
+
+#ifdef __AVX2__
+		for (; i + 8 <= cnt; i += 8) {
+			const size_t k = base + i;
+			const __m256 vx = _mm256_loadu_ps(x + k);
+			const __m256 vy = _mm256_loadu_ps(y + k);
+			const __m256 vz = _mm256_loadu_ps(z + k);
+			__m256 in = _mm256_and_ps(_mm256_cmp_ps(vfx, vx, _CMP_LE_OQ), _mm256_cmp_ps(vx, vtx, _CMP_LE_OQ));
+
+			in = _mm256_and_ps(in, _mm256_and_ps(_mm256_cmp_ps(vfy, vy, _CMP_LE_OQ), _mm256_cmp_ps(vy, vty, _CMP_LE_OQ)));
+			in = _mm256_and_ps(in, _mm256_and_ps(_mm256_cmp_ps(vfz, vz, _CMP_LE_OQ), _mm256_cmp_ps(vz, vtz, _CMP_LE_OQ)));
+			bits |= (uint64_t)_mm256_movemask_ps(in) << i;
+		}
+#endif
+		for (; i < cnt; i++) {
+			const size_t k = base + i;
+			const uint64_t in = (fx <= x[k]) & (x[k] <= tx) & (fy <= y[k]) & (y[k] <= ty) & (fz <= z[k]) & (z[k] <= tz);
+
+			bits |= in << i;
+		}
+		words[base >> 6] = bits;
+	}
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////
+// Parallel SoA range filter with bitmap output
+inline Bitmap scanBitmap(const PointsSoA& s, const Point& from, const Point& to) {
+	Bitmap bm(s.size());
+
+	parallelChunks(s.size(), 64, [&](size_t, size_t begin, size_t end) {
+		scanBitmap(s, from, to, bm, begin, end);
+	});
+	return bm;
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////
+// Parallel gather of the points selected by bm. The output is sized exactly once:
+// per-chunk popcounts give each chunk its write offset.
+inline std::vector<Point> gather(const std::vector<Point>& v, const Bitmap& bm) {
+	const size_t nThreads = std::max(1u, std::thread::hardware_concurrency());
+	std::vector<size_t> offsets(nThreads + 1);
+	std::vector<Point> result;
+
+	parallelChunks(bm.words(), 1, [&](size_t c, size_t wBegin, size_t wEnd) {
+		offsets[c + 1] = bm.count(wBegin, wEnd);
+	});
+	for (size_t c = 0; c < nThreads; c++) offsets[c + 1] += offsets[c];
+	result.resize(offsets[nThreads]);
+	parallelChunks(bm.words(), 1, [&](size_t c, size_t wBegin, size_t wEnd) {
+		Point* out = result.data() + offsets[c];
+
+		bm.forEach(wBegin, wEnd, [&](size_t i) { *out++ = v[i]; });
+	});
+	return result;
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////
+// Parallel AoS range filter without synchronization: every chunk collects its hits in a
+// local vector pre-sized by the expected number of hits, the local results are concatenated.
+inline std::vector<Point> scanAoS(const std::vector<Point>& v, const Point& from, const Point& to, size_t expected = 0) {
+	const size_t nThreads = std::max(1u, std::thread::hardware_concurrency());
+	std::vector<std::vector<Point>> local(nThreads);
+	std::vector<Point> result;
+
+	parallelChunks(v.size(), 1, [&](size_t c, size_t begin, size_t end) {
+		local[c].reserve(expected/nThreads + expected/(8*nThreads) + 16);
+		for (size_t i = begin; i < end; i++) {
+			if (from <= v[i] && v[i] <= to) local[c].push_back(v[i]);
+		}
+	});
+
+	size_t total = 0;
+	for (auto& l : local) total += l.size();
+	result.reserve(total);
+	for (auto& l : local) result.insert(result.end(), l.begin(), l.end());
+	return result;
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////
+// Selection vector: ascending positions of the matching elements of an input array
+// (inputs of up to 2^32 elements); a quarter of the size of materialized points
+using Selection = std::vector<uint32_t>;
+
+//////////////////////////////////////////////////////////////////////////////////////////////
+// Parallel conversion of a bitmap into a selection vector (exactly sized, like gather)
+inline Selection toSelection(const Bitmap& bm) {
+	const size_t nThreads = std::max(1u, std::thread::hardware_concurrency());
+	std::vector<size_t> offsets(nThreads + 1);
+	Selection sel;
+
+	parallelChunks(bm.words(), 1, [&](size_t c, size_t wBegin, size_t wEnd) {
+		offsets[c + 1] = bm.count(wBegin, wEnd);
+	});
+	for (size_t c = 0; c < nThreads; c++) offsets[c + 1] += offsets[c];
+	sel.resize(offsets[nThreads]);
+	parallelChunks(bm.words(), 1, [&](size_t c, size_t wBegin, size_t wEnd) {
+		uint32_t* out = sel.data() + offsets[c];
+
+		bm.forEach(wBegin, wEnd, [&](size_t i) { *out++ = (uint32_t)i; });
+	});
+	return sel;
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////
+// Parallel SoA range filter with selection vector output
+inline Selection scanSelection(const PointsSoA& s, const Point& from, const Point& to) {
+	return toSelection(scanBitmap(s, from, to));
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////
+// Parallel gather of the points selected by sel
+inline std::vector<Point> gather(const std::vector<Point>& v, const Selection& sel) {
+	std::vector<Point> result(sel.size());
+
+	parallelChunks(sel.size(), 1, [&](size_t, size_t begin, size_t end) {
+		for (size_t i = begin; i < end; i++) result[i] = v[sel[i]];
+	});
+	return result;
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////
+// Aggregation operators: coordinate sums of the selected points, read from the SoA columns
+struct PointSum {
+	double x = 0, y = 0, z = 0;
+
+	PointSum& operator+=(const PointSum& s) {
+		x += s.x; y += s.y; z += s.z;
+		return *this;
+	}
+};
+
+inline PointSum sum(const PointsSoA& s, const Bitmap& bm) {
+	const size_t nThreads = std::max(1u, std::thread::hardware_concurrency());
+	std::vector<PointSum> partial(nThreads);
+	PointSum total;
+
+	parallelChunks(bm.words(), 1, [&](size_t c, size_t wBegin, size_t wEnd) {
+		bm.forEach(wBegin, wEnd, [&](size_t i) { partial[c] += { s.x[i], s.y[i], s.z[i] }; });
+	});
+	for (const PointSum& p : partial) total += p;
+	return total;
+}
+
+inline PointSum sum(const PointsSoA& s, const Selection& sel) {
+	const size_t nThreads = std::max(1u, std::thread::hardware_concurrency());
+	std::vector<PointSum> partial(nThreads);
+	PointSum total;
+
+	parallelChunks(sel.size(), 1, [&](size_t c, size_t begin, size_t end) {
+		for (size_t i = begin; i < end; i++) partial[c] += { s.x[sel[i]], s.y[sel[i]], s.z[sel[i]] };
+	});
+	for (const PointSum& p : partial) total += p;
+	return total;
+}
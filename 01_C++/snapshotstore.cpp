@@ -0,0 +1,392 @@
+#include <algorithm>
+#include <atomic>
+#include <iostream>
+#include <iomanip>
+#include <limits>
+#include <memory>
+#include <mutex>
+#include <vector>
+#include <thread>
+#include <random>
+#include "Stopwatch.h"
+#include "point.h"
+#include "rangescan.h"
+
+//////////////////////////////////////////////////////////////////////////////////////////////
+// Point store with snapshot isolation.
+// The data is a list of immutable segments. Every batch of inserts or deletes publishes a new
+// version (copy of the segment list, new or replaced segments only where needed) with a single
+// atomic pointer exchange (RCU). Readers never lock: they announce the current global epoch in
+// their reader slot and then load the current version. A replaced version is retired with the
+// next epoch and freed as soon as all active readers have announced that epoch or a later one
+// (epoch-based reclamation). Writers are serialized by a mutex that readers never touch.
+class PointStore {
+	static constexpr size_t SegmentSize = 1 << 16;
+	static constexpr uint64_t Idle = std::numeric_limits<uint64_t>::max();
+
+	struct Segment {
+		std::shared_ptr<const std::vector<Point>> points;	// sorted, shared between versions
+		std::shared_ptr<const Bitmap> deleted;			// tombstones, nullptr if none
+		Point lo, hi;						// bounding box
+		size_t live;						// number of points not deleted
+	};
+
+	struct Version {
+		std::vector<Segment> segments;
+		size_t size = 0;
+	};
+
+	struct alignas(64) ReaderSlot {
+		std::atomic<uint64_t> epoch{ Idle };
+	};
+
+	std::atomic<const Version*> m_current;
+	std::atomic<uint64_t> m_epoch{ 1 };
+	std::vector<ReaderSlot> m_readers;
+	std::mutex m_writer;
+	std::vector<std::pair<uint64_t, const Version*>> m_retired;	// guarded by m_writer
+
+	static Segment makeSegment(std::vector<Point>&& sorted) {
+		float lo[3] = { sorted[0][0], sorted[0][1], sorted[0][2] };
+		float hi[3] = { lo[0], lo[1], lo[2] };
+
+		for (const Point& p : sorted) {
+			for (int d = 0; d < 3; d++) {
+				lo[d] = std::min(lo[d], p[d]);
+				hi[d] = std::max(hi[d], p[d]);
+			}
+		}
+		const size_t n = sorted.size();
+		return { std::make_shared<const std::vector<Point>>(std::move(sorted)), nullptr, { lo[0], lo[1], lo[2] }, { hi[0], hi[1], hi[2] }, n };
+	}
+
+	// live points of a segment
+	static std::vector<Point> livePoints(const Segment& s) {
+		std::vector<Point> v;
+
+		v.reserve(s.live);
+		for (size_t i = 0; i < s.points->size(); i++) {
+			if (!s.deleted || !s.deleted->test(i)) v.push_back((*s.points)[i]);
+		}
+		return v;
+	}
+
+	// appends sorted points as segments of at most SegmentSize points
+	static void appendSegments(Version& v, const std::vector<Point>& sorted) {
+		for (size_t i = 0; i < sorted.size(); i += SegmentSize) {
+			v.segments.push_back(makeSegment(std::vector<Point>(sorted.begin() + i, sorted.begin() + std::min(sorted.size(), i + SegmentSize))));
+		}
+	}
+
+	// must be called by the writer
+	void publish(Version* v) {
+		v->size = 0;
+		for (const Segment& s : v->segments) v->size += s.live;
+
+		const Version* old = m_current.exchange(v);
+		const uint64_t epoch = m_epoch.fetch_add(1) + 1;
+
+		m_retired.emplace_back(epoch, old);
+		reclaim();
+	}
+
+	// frees retired versions no active reader can hold anymore; must be called by the writer
+	void reclaim() {
+		uint64_t minEpoch = Idle;
+
+		for (const ReaderSlot& r : m_readers) minEpoch = std::min(minEpoch, r.epoch.load());
+
+		auto it = std::remove_if(m_retired.begin(), m_retired.end(), [minEpoch](const auto& r) {
+			if (r.first <= minEpoch) {
+				delete r.second;
+				return true;
+			}
+			return false;
+		});
+		m_retired.erase(it, m_retired.end());
+	}
+
+public:
+	//////////////////////////////////////////////////////////////////////////////////////////////
+	// Immutable view of the store; pins its version until destruction
+	class Snapshot {
+		std::atomic<uint64_t>* m_slot;
+		const Version* m_version;
+
+	public:
+		Snapshot(std::atomic<uint64_t>* slot, const Version* v) : m_slot(slot), m_version(v) {}
+		Snapshot(const Snapshot&) = delete;
+		Snapshot& operator=(const Snapshot&) = delete;
+		~Snapshot() { m_slot->store(Idle, std::memory_order_release); }
+
+		size_t size() const {
+			return m_version->size;
+		}
+
+		// points inside the box [from, to]
+		std::vector<Point> rangeQuery(const Point& from, const Point& to) const {
+			std::vector<Point> result;
+
+			for (const Segment& s : m_version->segments) {
+				if (!(from <= s.hi && s.lo <= to)) continue;
+
+				const std::vector<Point>& pts = *s.points;
+				const Bitmap* deleted = s.deleted.get();
+
+				// the points are sorted by x first, so only a sub-range has to be tested
+				auto first = std::lower_bound(pts.begin(), pts.end(), from[0], [](const Point& p, float x) { return p[0] < x; });
+				for (auto it = first; it != pts.end() && (*it)[0] <= to[0]; ++it) {
+					if (from <= *it && *it <= to && (!deleted || !deleted->test(it - pts.begin()))) result.push_back(*it);
+				}
+			}
+			return result;
+		}
+
+		// all live points
+		std::vector<Point> points() const {
+			std::vector<Point> v;
+
+			v.reserve(size());
+			for (const Segment& s : m_version->segments) {
+				std::vector<Point> live = livePoints(s);
+				v.insert(v.end(), live.begin(), live.end());
+			}
+			return v;
+		}
+	};
+
+	PointStore(const std::vector<Point>& initial, size_t maxReaders) : m_readers(maxReaders) {
+		Version* v = new Version;
+		std::vector<Point> sorted(initial);
+
+		std::sort(sorted.begin(), sorted.end());
+		appendSegments(*v, sorted);
+		for (const Segment& s : v->segments) v->size += s.live;
+		m_current.store(v);
+	}
+
+	~PointStore() {
+		delete m_current.load();
+		for (auto& r : m_retired) delete r.second;
+	}
+
+	//////////////////////////////////////////////////////////////////////////////////////////////
+	// lock-free snapshot for the reader with the given slot (0 <= reader < maxReaders)
+	// a reader must not hold more than one snapshot at a time
+	Snapshot snapshot(size_t reader) {
+		std::atomic<uint64_t>& slot = m_readers[reader].epoch;
+
+		slot.store(m_epoch.load());
+		return Snapshot(&slot, m_current.load());
+	}
+
+	//////////////////////////////////////////////////////////////////////////////////////////////
+	// inserts a batch of points
+	// small batches are merged into the last segment as long as it has room
+	void insert(std::vector<Point> batch) {
+		if (batch.empty()) return;
+		std::sort(batch.begin(), batch.end());
+
+		std::lock_guard<std::mutex> lock(m_writer);
+		Version* v = new Version(*m_current.load());
+
+		if (!v->segments.empty() && v->segments.back().live + batch.size() <= SegmentSize) {
+			std::vector<Point> last = livePoints(v->segments.back());
+			std::vector<Point> merged;
+
+			merged.reserve(last.size() + batch.size());
+			std::merge(last.begin(), last.end(), batch.begin(), batch.end(), std::back_inserter(merged));
+			v->segments.back() = makeSegment(std::move(merged));
+		} else {
+			appendSegments(*v, batch);
+		}
+		publish(v);
+	}
+
+	//////////////////////////////////////////////////////////////////////////////////////////////
+	// deletes one occurrence of every point in batch; unknown points are ignored
+	// deleted points become tombstones, segments with more tombstones than live points are rewritten
+	void erase(std::vector<Point> batch) {
+		if (batch.empty()) return;
+		std::sort(batch.begin(), batch.end());
+
+		std::lock_guard<std::mutex> lock(m_writer);
+		Version* v = new Version(*m_current.load());
+
+		for (Segment& s : v->segments) {
+			const std::vector<Point>& pts = *s.points;
+			std::unique_ptr<Bitmap> deleted;
+			size_t count = 0;
+
+			// batch points within the x-range of the segment
+			auto first = std::lower_bound(batch.begin(), batch.end(), pts.front());
+			auto last = std::upper_bound(first, batch.end(), pts.back());
+
+			for (auto it = first; it != last; ++it) {
+				if (!(s.lo <= *it && *it <= s.hi)) continue;
+
+				auto range = std::equal_range(pts.begin(), pts.end(), *it);
+				for (auto p = range.first; p != range.second; ++p) {
+					const size_t i = p - pts.begin();
+					const bool dead = (deleted ? deleted->test(i) : (s.deleted && s.deleted->test(i)));
+
+					if (!dead) {
+						if (!deleted) deleted = s.deleted ? std::make_unique<Bitmap>(*s.deleted) : std::make_unique<Bitmap>(pts.size());
+						deleted->set(i);
+						count++;
+						break;
+					}
+				}
+			}
+			if (count) {
+				s.deleted = std::move(deleted);
+				s.live -= count;
+				if (s.live > 0 && s.live < pts.size()/2) s = makeSegment(livePoints(s));
+			}
+		}
+		v->segments.erase(std::remove_if(v->segments.begin(), v->segments.end(), [](const Segment& s) { return s.live == 0; }), v->segments.end());
+		publish(v);
+	}
+
+	size_t retired() {
+		std::lock_guard<std::mutex> lock(m_writer);
+		return m_retired.size();
+	}
+};
+
+//////////////////////////////////////////////////////////////////////////////////////////////
+// Print latency statistics in ms
+static void report(const char text[], std::vector<double>& latencies, double t) {
+	std::sort(latencies.begin(), latencies.end());
+
+	const size_t n = latencies.size();
+	double sum = 0;
+	for (double l : latencies) sum += l;
+
+	std::cout << std::setw(30) << std::left << text << n << " queries in " << std::setprecision(2) << std::fixed << t << " ms";
+	if (n) {
+		std::cout << ", latency mean = " << sum/n << " ms, p50 = " << latencies[n/2] << " ms, p99 = " << latencies[n*99/100] << " ms, max = " << latencies.back() << " ms";
+	}
+	std::cout << std::endl;
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////
+// Mixed workload: one writer inserts and deletes batches while readers run range queries
+void snapshotStoreTests() {
+	std::cout << "\nSnapshot Store Tests" << std::endl;
+
+	constexpr int N = 10'000'000;
+	constexpr size_t Batch = 1000;
+	constexpr double Duration = 2000; // ms
+	const size_t nReaders = std::max(2u, std::thread::hardware_concurrency()) - 1;	// hardware_concurrency() may be 0
+
+	std::default_random_engine e;
+	Stopwatch sw;
+	std::vector<Point> points = randomPoints(N, e);
+
+	sw.Start();
+	PointStore store(points, nReaders + 1);
+	sw.Stop();
+	std::cout << "store loaded in " << sw.GetElapsedTimeMilliseconds() << " ms" << std::endl;
+
+	auto runReaders = [&](std::atomic<bool>& stop, std::vector<std::vector<double>>& latencies) {
+		std::vector<std::thread> readers;
+
+		for (size_t r = 0; r < nReaders; r++) {
+			readers.emplace_back([&, r] {
+				std::default_random_engine re((unsigned)r);
+				std::uniform_real_distribution<float> rdist;
+				Stopwatch swq;
+
+				while (!stop.load(std::memory_order_relaxed)) {
+					const float side = 0.05f;
+					const Point from(rdist(re)*(1 - side), rdist(re)*(1 - side), rdist(re)*(1 - side));
+					const Point to = from + Point(side, side, side);
+
+					swq.Restart();
+					{
+						const PointStore::Snapshot s = store.snapshot(r);
+						s.rangeQuery(from, to);
+					}
+					swq.Stop();
+					latencies[r].push_back(swq.GetElapsedTimeMilliseconds());
+				}
+			});
+		}
+		return readers;
+	};
+
+	// queries on a quiescent store
+	{
+		std::atomic<bool> stop = false;
+		std::vector<std::vector<double>> latencies(nReaders);
+
+		sw.Restart();
+		auto readers = runReaders(stop, latencies);
+		std::this_thread::sleep_for(std::chrono::milliseconds((int)Duration));
+		stop = true;
+		for (auto& t : readers) t.join();
+		sw.Stop();
+
+		std::vector<double> all;
+		for (auto& l : latencies) all.insert(all.end(), l.begin(), l.end());
+		report("Queries without updates:", all, sw.GetElapsedTimeMilliseconds());
+	}
+
+	// queries during concurrent inserts and deletes
+	{
+		std::atomic<bool> stop = false;
+		std::vector<std::vector<double>> latencies(nReaders);
+		size_t inserted = 0, deleted = 0;
+
+		sw.Restart();
+		auto readers = runReaders(stop, latencies);
+		std::thread writer([&] {
+			std::default_random_engine we(4711);
+			std::uniform_real_distribution<float> wdist;
+			std::vector<std::vector<Point>> pending;	// inserted batches, deleted later in FIFO order
+			Stopwatch sww;
+
+			sww.Start();
+			while (sww.GetSplitTimeMilliseconds() < Duration) {
+				std::vector<Point> batch;
+
+				batch.reserve(Batch);
+				for (size_t i = 0; i < Batch; i++) batch.emplace_back(wdist(we), wdist(we), wdist(we));
+				store.insert(batch);
+				inserted += batch.size();
+				pending.push_back(std::move(batch));
+				if (pending.size() > 8) {
+					store.erase(pending.front());
+					deleted += pending.front().size();
+					pending.erase(pending.begin());
+				}
+			}
+			sww.Stop();
+			const double t = sww.GetElapsedTimeMilliseconds();
+			std::cout << std::setw(30) << std::left << "Updates:" << inserted << " inserts, " << deleted << " deletes in " << t << " ms, ";
+			std::cout << (inserted + deleted)*1000/t << " points/s" << std::endl;
+		});
+		writer.join();
+		stop = true;
+		for (auto& t : readers) t.join();
+		sw.Stop();
+
+		std::vector<double> all;
+		for (auto& l : latencies) all.insert(all.end(), l.begin(), l.end());
+		report("Queries during updates:", all, sw.GetElapsedTimeMilliseconds());
+
+		// verify the final state against a frozen copy
+		const PointStore::Snapshot s = store.snapshot(nReaders);
+		const std::vector<Point> frozen = s.points();
+		const Point from(0.2f, 0.3f, 0.4f), to(0.5f, 0.6f, 0.7f);
+		std::vector<Point> ref = rqSerial(frozen, from, to);
+		std::vector<Point> result = s.rangeQuery(from, to);
+
+		std::sort(ref.begin(), ref.end());
+		std::sort(result.begin(), result.end());
+		std::cout << "versions not yet reclaimed: " << store.retired() << std::endl;
+		std::cout << std::boolalpha << "The store contains the expected number of points: " << (s.size() == N + inserted - deleted && frozen.size() == s.size()) << std::endl;
+		std::cout << std::boolalpha << "The two operations produce the same results: " << (ref == result) << std::endl;
+	}
+}
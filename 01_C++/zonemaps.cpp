@@ -0,0 +1,193 @@
+#include <algorithm>
+#include <execution>
+#include <cstdint>
+#include <iostream>
+#include <iomanip>
+#include <vector>
+#include <thread>
+#include <random>
+#include "Stopwatch.h"
+#include "point.h"
+#include "rangescan.h"
+
+//////////////////////////////////////////////////////////////////////////////////////////////
+// Zone maps: the points are split into fixed-size blocks and every block stores the minimum
+// and maximum of each coordinate. A range query skips blocks whose box misses the query box
+// and accepts blocks whose box lies inside the query box without testing single points.
+// Zone maps over random data are useless (every block spans the whole domain), therefore the
+// points can optionally be clustered along a Z-order (Morton) curve first.
+class ZoneMap {
+	static constexpr size_t BlockSize = 4096;
+
+	std::vector<Point> m_points;
+	std::vector<Point> m_lo, m_hi;	// bounding box per block
+
+	// interleaves the lower 10 bits of x with two zero bits each
+	static uint32_t spread(uint32_t x) {
+		x &= 0x3ff;
+		x = (x | (x << 16)) & 0x030000ff;
+		x = (x | (x << 8)) & 0x0300f00f;
+		x = (x | (x << 4)) & 0x030c30c3;
+		x = (x | (x << 2)) & 0x09249249;
+		return x;
+	}
+
+	// 30-bit Morton code of a point in [lo, hi]
+	static uint32_t morton(const Point& p, const float lo[3], const float scale[3]) {
+		uint32_t code = 0;
+
+		for (int d = 0; d < 3; d++) {
+			const uint32_t q = (uint32_t)std::clamp((p[d] - lo[d])*scale[d], 0.0f, 1023.0f);
+			code |= spread(q) << d;
+		}
+		return code;
+	}
+
+	void cluster() {
+		float lo[3], hi[3], scale[3];
+
+		if (m_points.empty()) return;
+
+		for (int d = 0; d < 3; d++) {
+			const auto [mn, mx] = std::minmax_element(m_points.begin(), m_points.end(), [d](const Point& a, const Point& b) { return a[d] < b[d]; });
+			lo[d] = (*mn)[d];
+			hi[d] = (*mx)[d];
+			scale[d] = (hi[d] > lo[d]) ? 1024/(hi[d] - lo[d]) : 0;
+		}
+
+		std::vector<std::pair<uint32_t, Point>> keyed(m_points.size());
+		std::transform(std::execution::par, m_points.begin(), m_points.end(), keyed.begin(), [&](const Point& p) {
+			return std::make_pair(morton(p, lo, scale), p);
+		});
+		std::sort(std::execution::par, keyed.begin(), keyed.end(), [](const auto& a, const auto& b) { return a.first < b.first; });
+		std::transform(std::execution::par, keyed.begin(), keyed.end(), m_points.begin(), [](const auto& k) { return k.second; });
+	}
+
+public:
+	struct Stats {
+		size_t blocks = 0;
+		size_t skipped = 0;	// blocks outside the query box
+		size_t accepted = 0;	// blocks inside the query box
+	};
+
+	ZoneMap(const std::vector<Point>& v, bool clustered) : m_points(v) {
+		if (m_points.empty()) return;	// no blocks
+		if (clustered) cluster();
+
+		const size_t nBlocks = (m_points.size() + BlockSize - 1)/BlockSize;
+		m_lo.resize(nBlocks);
+		m_hi.resize(nBlocks);
+		parallelChunks(nBlocks, 1, [&](size_t, size_t bBegin, size_t bEnd) {
+			for (size_t b = bBegin; b < bEnd; b++) {
+				const size_t end = std::min(m_points.size(), (b + 1)*BlockSize);
+				float lo[3] = { m_points[b*BlockSize][0], m_points[b*BlockSize][1], m_points[b*BlockSize][2] };
+				float hi[3] = { lo[0], lo[1], lo[2] };
+
+				for (size_t i = b*BlockSize + 1; i < end; i++) {
+					for (int d = 0; d < 3; d++) {
+						lo[d] = std::min(lo[d], m_points[i][d]);
+						hi[d] = std::max(hi[d], m_points[i][d]);
+					}
+				}
+				m_lo[b] = { lo[0], lo[1], lo[2] };
+				m_hi[b] = { hi[0], hi[1], hi[2] };
+			}
+		});
+	}
+
+	std::vector<Point> rangeQuery(const Point& from, const Point& to, Stats& stats) const {
+		const size_t nThreads = std::max(1u, std::thread::hardware_concurrency());
+		const size_t nBlocks = m_lo.size();
+		std::vector<std::vector<Point>> local(nThreads);
+		std::vector<Stats> localStats(nThreads);
+
+		parallelChunks(nBlocks, 1, [&](size_t c, size_t bBegin, size_t bEnd) {
+			std::vector<Point>& result = local[c];
+
+			for (size_t b = bBegin; b < bEnd; b++) {
+				const auto first = m_points.begin() + b*BlockSize;
+				const auto last = m_points.begin() + std::min(m_points.size(), (b + 1)*BlockSize);
+
+				if (!(from <= m_hi[b] && m_lo[b] <= to)) {
+					localStats[c].skipped++;
+				} else if (from <= m_lo[b] && m_hi[b] <= to) {
+					localStats[c].accepted++;
+					result.insert(result.end(), first, last);
+				} else {
+					std::copy_if(first, last, std::back_inserter(result), [&](const Point& p) { return from <= p && p <= to; });
+				}
+			}
+		});
+
+		std::vector<Point> result;
+		size_t total = 0;
+
+		for (auto& l : local) total += l.size();
+		result.reserve(total);
+		for (auto& l : local) result.insert(result.end(), l.begin(), l.end());
+
+		stats = { nBlocks, 0, 0 };
+		for (const Stats& s : localStats) {
+			stats.skipped += s.skipped;
+			stats.accepted += s.accepted;
+		}
+		return result;
+	}
+};
+
+//////////////////////////////////////////////////////////////////////////////////////////////
+// Zone-map block skipping on random and on Z-order clustered points
+void zoneMapTests() {
+	std::cout << "\nZone Map Tests" << std::endl;
+
+	constexpr int N = 10'000'000;
+
+	std::default_random_engine e;
+	std::uniform_real_distribution<float> dist;
+	Stopwatch sw;
+	std::vector<Point> points = randomPoints(N, e);
+
+	sw.Start();
+	const ZoneMap plain(points, false);
+	sw.Stop();
+	std::cout << "zone maps built in " << sw.GetElapsedTimeMilliseconds() << " ms" << std::endl;
+
+	sw.Restart();
+	const ZoneMap clustered(points, true);
+	sw.Stop();
+	std::cout << "points clustered and zone maps built in " << sw.GetElapsedTimeMilliseconds() << " ms" << std::endl;
+
+	for (float side : { 0.01f, 0.05f, 0.2f, 0.5f }) {
+		const Point from(dist(e)*(1 - side), dist(e)*(1 - side), dist(e)*(1 - side));
+		const Point to = from + Point(side, side, side);
+
+		std::cout << "\nbox side = " << side << std::endl;
+
+		sw.Restart();
+		std::vector<Point> resultS = rqSerial(points, from, to);
+		sw.Stop();
+		const double ts = sw.GetElapsedTimeMilliseconds();
+		std::sort(resultS.begin(), resultS.end());
+		check("Sequential:", resultS, resultS, ts, ts);
+
+		sw.Restart();
+		std::vector<Point> resultScan = scanAoS(points, from, to);
+		sw.Stop();
+		const double tScan = sw.GetElapsedTimeMilliseconds();
+		std::sort(resultScan.begin(), resultScan.end());
+		check("Parallel full scan:", resultS, resultScan, ts, tScan);
+
+		for (const ZoneMap* zm : { &plain, &clustered }) {
+			ZoneMap::Stats stats;
+
+			sw.Restart();
+			std::vector<Point> result = zm->rangeQuery(from, to, stats);
+			sw.Stop();
+			const double t = sw.GetElapsedTimeMilliseconds();
+			std::sort(result.begin(), result.end());
+			std::cout << "blocks skipped: " << 100.0*stats.skipped/stats.blocks << " %, accepted without test: " << 100.0*stats.accepted/stats.blocks;
+			std::cout << " %, speedup vs full scan = " << tScan/t << std::endl;
+			check((zm == &plain) ? "Zone maps (unclustered):" : "Zone maps (Z-order):", resultS, result, ts, t);
+		}
+	}
+}
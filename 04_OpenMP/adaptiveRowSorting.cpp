@@ -0,0 +1,204 @@
+#include <iostream>
+#include <climits>
+#include <cstring>
+#include <omp.h>
+#include <algorithm>
+#include <iomanip>
+#include <vector>
+#include <random>
+#include <string>
+#include "Stopwatch.h"
+#include "matrix.h"
+#include "radixsort.h"
+
+// implemented in matrixRowSorting.cpp
+void matrixSortSeq(Matrix<int>& A, RowSorter sorter);
+void matrixSortOmp(Matrix<int>& A, RowSorter sorter);
+
+//////////////////////////////////////////////////////////////////////////////////////////////
+// Parallelization strategies for sorting the rows of a matrix
+// Rows:  one row per iteration of a static parallel for, best for many rows
+// Tasks: one task per row, long rows are split further by a task-parallel merge sort, so
+//        threads without rows of their own help with the subtasks of other rows
+// Intra: the rows are sorted one after another, each by all threads (parallel merge sort)
+enum class Strategy { Rows, Tasks, Intra };
+
+static const char* strategyName(Strategy s) {
+	switch (s) {
+	case Strategy::Rows: return "rows";
+	case Strategy::Tasks: return "tasks";
+	default: return "intra-row";
+	}
+}
+
+static constexpr size_t RowsPerThread = 4;	// static row distribution is balanced within 25 %
+static constexpr size_t MinGrain = 1 << 14;	// smallest part of a row sorted by a single task
+
+//////////////////////////////////////////////////////////////////////////////////////////////
+// Chooses the strategy from the row count, the row length and the number of threads
+static Strategy chooseStrategy(size_t rows, size_t cols, int p) {
+	if (p == 1 || rows >= RowsPerThread*p || cols < 2*MinGrain) return Strategy::Rows;
+	if (rows < (size_t)p) return Strategy::Intra;
+	return Strategy::Tasks;
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////
+// Task-parallel merge of a[0..na) and b[0..nb) into out: the median of the longer input
+// splits both inputs into two independent merges
+static void parallelMerge(const int* a, size_t na, const int* b, size_t nb, int* out, size_t grain) {
+	if (na < nb) {
+		std::swap(a, b);
+		std::swap(na, nb);
+	}
+	if (na + nb <= grain) {
+		std::merge(a, a + na, b, b + nb, out);
+		return;
+	}
+
+	const size_t ma = na/2;
+	const size_t mb = std::lower_bound(b, b + nb, a[ma]) - b;
+
+	out[ma + mb] = a[ma];
+	#pragma omp task default(none) firstprivate(a, b, out, ma, mb, grain)
+	parallelMerge(a, ma, b, mb, out, grain);
+	#pragma omp task default(none) firstprivate(a, b, out, na, nb, ma, mb, grain)
+	parallelMerge(a + ma + 1, na - ma - 1, b + mb, nb - mb, out + ma + mb + 1, grain);
+	#pragma omp taskwait
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////
+// Task-parallel merge sort of src[0..n) with a buffer dst of the same size. The two buffers
+// change roles on every level, hence the result ends in dst if toDst is set, otherwise in src.
+// Parts of at most grain elements are sorted with the row-sorting engine.
+static void mergeSort(int* src, int* dst, size_t n, size_t grain, bool toDst, RowSorter sorter, std::vector<std::vector<uint32_t>>& scratch) {
+	if (n <= grain) {
+		sortRow({ src, n }, sorter, scratch[omp_get_thread_num()]);
+		if (toDst) std::memcpy(dst, src, n*sizeof(int));
+		return;
+	}
+
+	const size_t h = n/2;
+
+	#pragma omp task default(none) firstprivate(src, dst, h, grain, toDst, sorter) shared(scratch)
+	mergeSort(src, dst, h, grain, !toDst, sorter, scratch);
+	#pragma omp task default(none) firstprivate(src, dst, n, h, grain, toDst, sorter) shared(scratch)
+	mergeSort(src + h, dst + h, n - h, grain, !toDst, sorter, scratch);
+	#pragma omp taskwait
+
+	if (toDst) {
+		parallelMerge(src, h, src + h, n - h, dst, grain);
+	} else {
+		parallelMerge(dst, h, dst + h, n - h, src, grain);
+	}
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////
+// Sorts all rows of A with the given strategy
+static void matrixSortHybrid(Matrix<int>& A, Strategy strategy, RowSorter sorter = RowSorter::StdSort) {
+	const int p = omp_get_max_threads();
+	const size_t rows = A.rows();
+	const size_t cols = A.cols();
+	std::vector<std::vector<uint32_t>> scratch(p);
+
+	switch (strategy) {
+	case Strategy::Rows:
+		matrixSortOmp(A, sorter);
+		break;
+
+	case Strategy::Tasks: {
+		// about RowsPerThread leaf tasks per thread over all rows
+		const size_t parts = (RowsPerThread*p + rows - 1)/rows;
+		const size_t grain = std::max(MinGrain, (cols + parts - 1)/parts);
+
+		#pragma omp parallel default(none) shared(A, scratch) firstprivate(rows, cols, grain, sorter) num_threads(p)
+		#pragma omp single
+		for (size_t i = 0; i < rows; i++) {
+			#pragma omp task default(none) shared(A, scratch) firstprivate(i, cols, grain, sorter)
+			{
+				const std::span<int> row = A[i];
+
+				if (cols <= grain) {
+					sortRow(row, sorter, scratch[omp_get_thread_num()]);
+				} else {
+					std::vector<int> tmp(cols);
+
+					mergeSort(row.data(), tmp.data(), cols, grain, false, sorter, scratch);
+				}
+			}
+		}
+		break;
+	}
+
+	case Strategy::Intra: {
+		const size_t grain = std::max(MinGrain, (cols + RowsPerThread*p - 1)/(RowsPerThread*p));
+		std::vector<int> tmp(cols);
+
+		#pragma omp parallel default(none) shared(A, scratch, tmp) firstprivate(rows, cols, grain, sorter) num_threads(p)
+		#pragma omp single
+		for (size_t i = 0; i < rows; i++) {
+			mergeSort(A[i].data(), tmp.data(), cols, grain, false, sorter, scratch);
+		}
+		break;
+	}
+	}
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////
+// Check and print results
+static void check(const char text[], const Matrix<int>& ref, const Matrix<int>& result, double ts, double tp) {
+	static const int p = omp_get_num_procs();
+	const double S = ts/tp;
+	const double E = S/p;
+
+	std::cout << std::setw(30) << std::left << text << result.size();
+	std::cout << " in " << std::right << std::setw(7) << std::setprecision(2) << std::fixed << tp << " ms, S = " << S << ", E = " << E << std::endl;
+	std::cout << std::boolalpha << "The two operations produce the same results: " << (ref == result) << std::endl << std::endl;
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////
+// Random matrix, every row is filled by its own generator, so the content does not depend
+// on the thread that initializes the row
+static Matrix<int> randomMatrix(size_t rows, size_t cols) {
+	Matrix<int> A(rows, cols);
+
+	A.init([](size_t i, std::span<int> row) {
+		std::default_random_engine e((unsigned)i);
+		std::uniform_int_distribution<int> dist(INT_MIN, INT_MAX);
+
+		for (int& v : row) v = dist(e);
+	});
+	return A;
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////
+// Strategies for matrices of different aspect ratios
+void adaptiveRowSortingTests() {
+	std::cout << "\nAdaptive Row Sorting Tests" << std::endl;
+
+	const int p = omp_get_max_threads();
+	const std::pair<size_t, size_t> shapes[] = { { 8, 5'000'000 }, { 2*(size_t)p, 1'000'000 }, { 100, 200'000 }, { 5000, 1000 } };
+	Stopwatch sw;
+
+	for (auto [rows, cols] : shapes) {
+		const Strategy chosen = chooseStrategy(rows, cols, p);
+
+		std::cout << "\nmatrix: " << rows << " x " << cols << ", threads: " << p << ", chosen strategy: " << strategyName(chosen) << std::endl;
+
+		Matrix<int> ref = randomMatrix(rows, cols);
+		sw.Restart();
+		matrixSortSeq(ref, RowSorter::StdSort);
+		sw.Stop();
+		const double ts = sw.GetElapsedTimeMilliseconds();
+		std::cout << "Serial in " << ts << " ms" << std::endl;
+
+		for (Strategy s : { Strategy::Rows, Strategy::Tasks, Strategy::Intra }) {
+			Matrix<int> A = randomMatrix(rows, cols);
+
+			sw.Restart();
+			matrixSortHybrid(A, s);
+			sw.Stop();
+			const std::string label = std::string((s == chosen) ? "* " : "  ") + strategyName(s) + ":";
+			check(label.c_str(), ref, A, ts, sw.GetElapsedTimeMilliseconds());
+		}
+	}
+}
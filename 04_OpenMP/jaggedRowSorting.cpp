@@ -0,0 +1,224 @@
+#include <iostream>
+#include <atomic>
+#include <cmath>
+#include <cstdint>
+#include <omp.h>
+#include <algorithm>
+#include <functional>
+#include <iomanip>
+#include <numeric>
+#include <queue>
+#include <vector>
+#include <random>
+#include "Stopwatch.h"
+#include "matrix.h"
+#include "radixsort.h"
+
+//////////////////////////////////////////////////////////////////////////////////////////////
+// Estimated cost of sorting a row of n elements
+static double sortCost(size_t n) {
+	return n*std::log2(n + 2.0);
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////
+// Per-thread busy times of one run, used to show the load imbalance
+struct Balance {
+	std::vector<double> busy;
+
+	explicit Balance(int p) : busy(p) {}
+
+	// maximum over average busy time: 1 is perfect balance
+	double imbalance() const {
+		const double mx = *std::max_element(busy.begin(), busy.end());
+		const double avg = std::accumulate(busy.begin(), busy.end(), 0.0)/busy.size();
+
+		return (avg > 0) ? mx/avg : 1;
+	}
+};
+
+//////////////////////////////////////////////////////////////////////////////////////////////
+// Sorting the rows with one of the OpenMP loop schedules (schedule(runtime) selects it)
+// The run-sched-var is process-wide, so the previous setting is restored afterwards.
+static void jaggedSortOmp(JaggedMatrix<int>& A, omp_sched_t kind, Balance& balance) {
+	omp_sched_t prevKind;
+	int prevChunk;
+
+	omp_get_schedule(&prevKind, &prevChunk);
+	omp_set_schedule(kind, 0);
+
+	#pragma omp parallel default(none) shared(A, balance)
+	{
+		std::vector<uint32_t> scratch;
+		const double start = omp_get_wtime();
+
+		#pragma omp for schedule(runtime) nowait
+		for (size_t i = 0; i < A.rows(); i++) {
+			sortRow(A[i], RowSorter::StdSort, scratch);
+		}
+		balance.busy[omp_get_thread_num()] = omp_get_wtime() - start;
+	}
+	omp_set_schedule(prevKind, prevChunk);
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////
+// Work queue of one thread: a range of a row order array. The owner takes rows from the head
+// (its longest rows first), thieves take rows from the tail (the shortest rows). Head and tail
+// are packed into one 64-bit word, so both ends are claimed with a single CAS and the queue
+// needs no lock.
+class alignas(64) StealQueue {
+	std::atomic<uint64_t> m_range { 0 };	// head in the upper, tail in the lower 32 bits
+
+	static uint64_t pack(uint32_t head, uint32_t tail) { return (uint64_t(head) << 32) | tail; }
+
+public:
+	void reset(uint32_t head, uint32_t tail) {
+		m_range.store(pack(head, tail), std::memory_order_relaxed);
+	}
+
+	// returns the claimed position or -1 if the queue is empty
+	int64_t popHead() {
+		uint64_t r = m_range.load(std::memory_order_relaxed);
+
+		while (true) {
+			const uint32_t head = uint32_t(r >> 32), tail = uint32_t(r);
+
+			if (head >= tail) return -1;
+			if (m_range.compare_exchange_weak(r, pack(head + 1, tail), std::memory_order_acq_rel, std::memory_order_relaxed)) return head;
+		}
+	}
+
+	int64_t popTail() {
+		uint64_t r = m_range.load(std::memory_order_relaxed);
+
+		while (true) {
+			const uint32_t head = uint32_t(r >> 32), tail = uint32_t(r);
+
+			if (head >= tail) return -1;
+			if (m_range.compare_exchange_weak(r, pack(head, tail - 1), std::memory_order_acq_rel, std::memory_order_relaxed)) return tail - 1;
+		}
+	}
+};
+
+//////////////////////////////////////////////////////////////////////////////////////////////
+// LPT scheduling with work stealing
+// The rows are ordered by estimated cost, longest first, and greedily assigned to the thread
+// with the currently smallest total cost (longest processing time first). Every thread sorts
+// its own rows longest first; a thread that runs out of rows steals the shortest remaining
+// rows of the other threads, which evens out the estimation errors at the tail.
+static void jaggedSortLPT(JaggedMatrix<int>& A, Balance& balance) {
+	const int p = omp_get_max_threads();
+	const size_t rows = A.rows();
+	std::vector<uint32_t> byCost(rows);
+	std::vector<std::vector<uint32_t>> assigned(p);
+	std::vector<uint32_t> order;	// the rows of all threads, thread by thread
+	std::vector<StealQueue> queues(p);
+
+	std::iota(byCost.begin(), byCost.end(), 0);
+	std::sort(byCost.begin(), byCost.end(), [&A](uint32_t a, uint32_t b) { return A.length(a) > A.length(b); });
+
+	using Load = std::pair<double, int>;	// (assigned cost, thread)
+	std::priority_queue<Load, std::vector<Load>, std::greater<Load>> loads;
+
+	for (int t = 0; t < p; t++) loads.push({ 0, t });
+	for (uint32_t i : byCost) {
+		auto [cost, t] = loads.top();
+
+		loads.pop();
+		assigned[t].push_back(i);
+		loads.push({ cost + sortCost(A.length(i)), t });
+	}
+	order.reserve(rows);
+	for (int t = 0; t < p; t++) {
+		const uint32_t head = (uint32_t)order.size();
+
+		order.insert(order.end(), assigned[t].begin(), assigned[t].end());
+		queues[t].reset(head, (uint32_t)order.size());
+	}
+
+	#pragma omp parallel default(none) shared(A, balance, order, queues) firstprivate(p) num_threads(p)
+	{
+		const int t = omp_get_thread_num();
+		const double start = omp_get_wtime();
+		std::vector<uint32_t> scratch;
+		int64_t pos;
+
+		// own rows, longest first
+		while ((pos = queues[t].popHead()) >= 0) {
+			sortRow(A[order[pos]], RowSorter::StdSort, scratch);
+		}
+		// tail: steal the shortest rows of the other threads
+		for (int k = 1; k < p; k++) {
+			StealQueue& victim = queues[(t + k) % p];
+
+			while ((pos = victim.popTail()) >= 0) {
+				sortRow(A[order[pos]], RowSorter::StdSort, scratch);
+			}
+		}
+		balance.busy[t] = omp_get_wtime() - start;
+	}
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////
+// Check and print results
+static void check(const char text[], const JaggedMatrix<int>& ref, const JaggedMatrix<int>& result, double ts, double tp, const Balance& balance) {
+	static const int p = omp_get_num_procs();
+	const double S = ts/tp;
+	const double E = S/p;
+
+	std::cout << std::setw(30) << std::left << text << result.size();
+	std::cout << " in " << std::right << std::setw(7) << std::setprecision(2) << std::fixed << tp << " ms, S = " << S << ", E = " << E;
+	std::cout << ", imbalance = " << balance.imbalance() << std::endl;
+	std::cout << std::boolalpha << "The two operations produce the same results: " << (ref == result) << std::endl << std::endl;
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////
+// Jagged rows with log-uniformly distributed lengths (four orders of magnitude)
+void jaggedRowSortingTests() {
+	constexpr size_t Rows = 2000;
+	constexpr double MinLength = 20, MaxLength = 200'000;
+
+	std::cout << "\nJagged Row Sorting Tests" << std::endl;
+
+	const int p = omp_get_max_threads();
+	std::default_random_engine e;
+	std::uniform_real_distribution<double> logLength(std::log(MinLength), std::log(MaxLength));
+	std::uniform_int_distribution dist;
+	std::vector<size_t> lengths(Rows);
+	Stopwatch sw;
+
+	for (size_t& n : lengths) n = (size_t)std::exp(logLength(e));
+
+	JaggedMatrix<int> input(lengths);
+	for (int& v : input.data()) v = dist(e);
+	std::cout << "rows: " << Rows << ", elements: " << input.elements() << ", threads: " << p << std::endl;
+
+	JaggedMatrix<int> ref = input;
+	std::vector<uint32_t> scratch;
+	sw.Start();
+	for (size_t i = 0; i < ref.rows(); i++) sortRow(ref[i], RowSorter::StdSort, scratch);
+	sw.Stop();
+	const double ts = sw.GetElapsedTimeMilliseconds();
+	std::cout << "Serial in " << ts << " ms" << std::endl << std::endl;
+
+	const std::pair<const char*, omp_sched_t> schedules[] = {
+		{ "OMP static:", omp_sched_static }, { "OMP dynamic:", omp_sched_dynamic }, { "OMP guided:", omp_sched_guided }
+	};
+
+	for (auto [name, kind] : schedules) {
+		JaggedMatrix<int> A = input;
+		Balance balance(p);
+
+		sw.Restart();
+		jaggedSortOmp(A, kind, balance);
+		sw.Stop();
+		check(name, ref, A, ts, sw.GetElapsedTimeMilliseconds(), balance);
+	}
+
+	JaggedMatrix<int> A = input;
+	Balance balance(p);
+
+	sw.Restart();
+	jaggedSortLPT(A, balance);
+	sw.Stop();
+	check("LPT with stealing:", ref, A, ts, sw.GetElapsedTimeMilliseconds(), balance);
+}
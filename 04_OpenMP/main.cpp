@@ -5,9 +5,21 @@
 // It's the task of the C++ linker to put all parts of a program together.
 void summationTests();
 void matrixRowSortingTests();
+void matrixLayoutTests();
+void adaptiveRowSortingTests();
+void jaggedRowSortingTests();
+void meshSortingTests();
+void syncPrimitivesTests();
+void streamingReductionTests();
 
 // main program
 int main() {
 	summationTests();
 	matrixRowSortingTests();
+	matrixLayoutTests();
+	adaptiveRowSortingTests();
+	jaggedRowSortingTests();
+	meshSortingTests();
+	syncPrimitivesTests();
+	streamingReductionTests();
 }
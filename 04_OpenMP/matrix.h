@@ -0,0 +1,139 @@
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <new>
+#include <span>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+//////////////////////////////////////////////////////////////////////////////////////////////
+// Row-major matrix in one aligned allocation.
+// Every row starts on a cache line: the row stride is the number of columns rounded up to a
+// multiple of a cache line, plus one cache line if the stride would be a multiple of 4 KB
+// (otherwise rows processed in lock-step map to the same cache sets).
+// The constructor does not touch the memory: with init() every thread writes the rows it
+// will later process, hence the pages are placed on that thread's NUMA node (first touch).
+template<typename T>
+class Matrix {
+	static_assert(std::is_trivially_copyable_v<T>, "Matrix requires trivially copyable elements");
+
+	static constexpr size_t Alignment = 64;
+	static constexpr size_t LineElems = Alignment/sizeof(T);
+
+	size_t m_rows = 0;
+	size_t m_cols = 0;
+	size_t m_stride = 0;	// elements between two row starts
+	T* m_data = nullptr;
+
+	static size_t stride(size_t cols) {
+		size_t s = (cols + LineElems - 1)/LineElems*LineElems;
+
+		if ((s*sizeof(T)) % 4096 == 0) s += LineElems;
+		return s;
+	}
+
+	void release() {
+		if (m_data) ::operator delete(m_data, std::align_val_t(Alignment));
+		m_data = nullptr;
+	}
+
+public:
+	Matrix() = default;
+
+	Matrix(size_t rows, size_t cols)
+		: m_rows(rows), m_cols(cols), m_stride(stride(cols))
+		, m_data(static_cast<T*>(::operator new(rows*m_stride*sizeof(T), std::align_val_t(Alignment))))
+	{}
+
+	Matrix(const Matrix&) = delete;
+	Matrix& operator=(const Matrix&) = delete;
+
+	Matrix(Matrix&& m) noexcept
+		: m_rows(std::exchange(m.m_rows, 0)), m_cols(std::exchange(m.m_cols, 0))
+		, m_stride(std::exchange(m.m_stride, 0)), m_data(std::exchange(m.m_data, nullptr))
+	{}
+
+	Matrix& operator=(Matrix&& m) noexcept {
+		if (this != &m) {
+			release();
+			m_rows = std::exchange(m.m_rows, 0);
+			m_cols = std::exchange(m.m_cols, 0);
+			m_stride = std::exchange(m.m_stride, 0);
+			m_data = std::exchange(m.m_data, nullptr);
+		}
+		return *this;
+	}
+
+	~Matrix() {
+		release();
+	}
+
+	size_t size() const { return m_rows; }
+	size_t rows() const { return m_rows; }
+	size_t cols() const { return m_cols; }
+	size_t stride() const { return m_stride; }
+
+	// allocated bytes including the padding
+	size_t bytes() const { return m_rows*m_stride*sizeof(T); }
+
+	T* data() { return m_data; }
+	const T* data() const { return m_data; }
+
+	std::span<T> operator[](size_t i) { return { m_data + i*m_stride, m_cols }; }
+	std::span<const T> operator[](size_t i) const { return { m_data + i*m_stride, m_cols }; }
+
+	// parallel first-touch initialization: calls f(i, row) for every row i with the same
+	// static schedule as the row-parallel algorithms
+	template<typename F>
+	void init(F f) {
+		#pragma omp parallel for schedule(static)
+		for (size_t i = 0; i < m_rows; i++) {
+			f(i, (*this)[i]);
+		}
+	}
+
+	bool operator==(const Matrix& m) const {
+		if (m_rows != m.m_rows || m_cols != m.m_cols) return false;
+		for (size_t i = 0; i < m_rows; i++) {
+			const auto a = (*this)[i];
+			const auto b = m[i];
+
+			if (!std::equal(a.begin(), a.end(), b.begin())) return false;
+		}
+		return true;
+	}
+};
+
+//////////////////////////////////////////////////////////////////////////////////////////////
+// Jagged rows in CSR form: all rows in one buffer, row i is data[offsets[i], offsets[i + 1])
+template<typename T>
+class JaggedMatrix {
+	std::vector<T> m_data;
+	std::vector<size_t> m_offsets;
+
+public:
+	JaggedMatrix() : m_offsets(1) {}
+
+	// allocates rows of the given lengths
+	explicit JaggedMatrix(const std::vector<size_t>& lengths) : m_offsets(lengths.size() + 1) {
+		for (size_t i = 0; i < lengths.size(); i++) m_offsets[i + 1] = m_offsets[i] + lengths[i];
+		m_data.resize(m_offsets.back());
+	}
+
+	size_t size() const { return rows(); }
+	size_t rows() const { return m_offsets.size() - 1; }
+	size_t elements() const { return m_data.size(); }
+	size_t length(size_t i) const { return m_offsets[i + 1] - m_offsets[i]; }
+	const std::vector<size_t>& offsets() const { return m_offsets; }
+	std::vector<T>& data() { return m_data; }
+	const std::vector<T>& data() const { return m_data; }
+
+	std::span<T> operator[](size_t i) { return { m_data.data() + m_offsets[i], length(i) }; }
+	std::span<const T> operator[](size_t i) const { return { m_data.data() + m_offsets[i], length(i) }; }
+
+	bool operator==(const JaggedMatrix& m) const {
+		return m_offsets == m.m_offsets && m_data == m.m_data;
+	}
+};
@@ -1,30 +1,64 @@
 #include <iostream>
 #include <cmath>
 #include <climits>
+#include <cstdint>
 #include <omp.h>
 #include <algorithm>
 #include <iomanip>
 #include <vector>
 #include <random>
 #include "Stopwatch.h"
+#include "matrix.h"
+#include "radixsort.h"
 
 //////////////////////////////////////////////////////////////////////////////////////////////
 // sequentially sorting all arrays A[i]
-void matrixSortSeq(std::vector<std::vector<int>>& A) {
+void matrixSortSeq(std::vector<std::vector<int>>& A, RowSorter sorter = RowSorter::StdSort) {
+	std::vector<uint32_t> scratch;
+
 	for (size_t i = 0; i < A.size(); i++) {
-		std::sort(A[i].begin(), A[i].end());
+		sortRow(A[i], sorter, scratch);
 	}
 }
 
 //////////////////////////////////////////////////////////////////////////////////////////////
 // parallel sorting all arrays A[i]
-void matrixSortOmp(std::vector<std::vector<int>>& A) {
+// every thread reuses its own radix sort scratch buffer for all its rows
+void matrixSortOmp(std::vector<std::vector<int>>& A, RowSorter sorter = RowSorter::StdSort) {
 	// DONE use OMP to parallelize a for loop
-	#pragma omp parallel for schedule(static) num_threads(omp_get_max_threads())
-	for (size_t i = 0; i < A.size(); i++) {
-		std::sort(A[i].begin(), A[i].end());
+	#pragma omp parallel num_threads(omp_get_max_threads())
+	{
+		std::vector<uint32_t> scratch;
+
+		#pragma omp for schedule(static)
+		for (size_t i = 0; i < A.size(); i++) {
+			sortRow(A[i], sorter, scratch);
+		}
 	}
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////
+// sequentially sorting all rows of a contiguous matrix
+void matrixSortSeq(Matrix<int>& A, RowSorter sorter = RowSorter::StdSort) {
+	std::vector<uint32_t> scratch;
 
+	for (size_t i = 0; i < A.rows(); i++) {
+		sortRow(A[i], sorter, scratch);
+	}
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////
+// parallel sorting all rows of a contiguous matrix
+void matrixSortOmp(Matrix<int>& A, RowSorter sorter = RowSorter::StdSort) {
+	#pragma omp parallel num_threads(omp_get_max_threads())
+	{
+		std::vector<uint32_t> scratch;
+
+		#pragma omp for schedule(static)
+		for (size_t i = 0; i < A.rows(); i++) {
+			sortRow(A[i], sorter, scratch);
+		}
+	}
 }
 
 //////////////////////////////////////////////////////////////////////////////////////////////
@@ -50,6 +84,24 @@ void matrixRowSortingTests() {
 	std::default_random_engine e;
 	std::uniform_int_distribution dist;
 
+	// radix sort of signed keys over the full int range
+	{
+		std::default_random_engine re;
+		std::uniform_int_distribution<int> full(INT_MIN, INT_MAX);
+		std::vector<int> ref(N);
+		std::vector<uint32_t> scratch(N);
+
+		for (int& v : ref) v = full(re);
+		ref[0] = INT_MIN;
+		ref[1] = INT_MAX;
+		ref[2] = -1;
+		ref[3] = 0;
+		std::vector<int> keys(ref);
+		std::sort(ref.begin(), ref.end());
+		radixSort(keys, scratch);
+		std::cout << std::boolalpha << "Radix sort of signed keys: " << (ref == keys) << std::endl;
+	}
+
 	for (size_t n1 = 1000; n1 <= 2000; n1 += 200) {
 		std::cout << "n = " << n1 << std::endl;
 		std::vector<std::vector<int>> A(n1);
@@ -63,6 +115,8 @@ void matrixRowSortingTests() {
 				A[i][j] = B[i][j] = dist(e);
 			}
 		}
+		std::vector<std::vector<int>> C(B);
+		std::vector<std::vector<int>> D(B);
 
 		// run serial implementation
 		swSER.Restart();
@@ -76,5 +130,119 @@ void matrixRowSortingTests() {
 		swOMP.Stop();
 
 		check("Matrix Row Sorting:", A, B, ts, swOMP.GetElapsedTimeMilliseconds());
+
+		// run radix sort as row-sorting engine
+		swSER.Restart();
+		matrixSortSeq(C, RowSorter::Radix);
+		swSER.Stop();
+		check("Radix Row Sorting Seq:", A, C, ts, swSER.GetElapsedTimeMilliseconds());
+
+		swOMP.Restart();
+		matrixSortOmp(D, RowSorter::Radix);
+		swOMP.Stop();
+		check("Radix Row Sorting OMP:", A, D, ts, swOMP.GetElapsedTimeMilliseconds());
+	}
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////
+// Deterministic pseudo-random value of element (i, j), independent of the thread computing it
+static int value(size_t i, size_t j) {
+	uint64_t x = (uint64_t(i) << 32) ^ j;
+
+	x = (x ^ (x >> 30))*0xbf58476d1ce4e5b9ull;
+	x = (x ^ (x >> 27))*0x94d049bb133111ebull;
+	x ^= x >> 31;
+	return (int)(x >> 33);
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////
+static bool same(const std::vector<std::vector<int>>& A, const Matrix<int>& B) {
+	if (A.size() != B.rows()) return false;
+	for (size_t i = 0; i < A.size(); i++) {
+		if (!std::equal(A[i].begin(), A[i].end(), B[i].begin(), B[i].end())) return false;
+	}
+	return true;
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////
+// End-to-end time (allocation, initialization and sorting) and memory of nested vectors
+// against a contiguous matrix with parallel first-touch initialization
+void matrixLayoutTests() {
+	constexpr size_t N = 50'000;
+	constexpr double MB = 1024*1024;
+
+	std::cout << "\nMatrix Layout Tests" << std::endl;
+
+	Stopwatch sw;
+
+	for (size_t n1 = 1000; n1 <= 2000; n1 += 500) {
+		std::cout << "n = " << n1 << std::endl;
+
+		// nested vectors: one heap allocation per row
+		sw.Restart();
+		std::vector<std::vector<int>> A(n1);
+		for (size_t i = 0; i < n1; i++) {
+			A[i].resize(N);
+			for (size_t j = 0; j < N; j++) A[i][j] = value(i, j);
+		}
+		sw.Stop();
+		const double tInitA = sw.GetElapsedTimeMilliseconds();
+		sw.Restart();
+		matrixSortSeq(A);
+		sw.Stop();
+		const double ts = sw.GetElapsedTimeMilliseconds();
+		const double tsA = tInitA + ts;
+
+		sw.Restart();
+		std::vector<std::vector<int>> B(n1);
+		#pragma omp parallel for schedule(static)
+		for (size_t i = 0; i < n1; i++) {
+			B[i].resize(N);
+			for (size_t j = 0; j < N; j++) B[i][j] = value(i, j);
+		}
+		sw.Stop();
+		const double tInitB = sw.GetElapsedTimeMilliseconds();
+		sw.Restart();
+		matrixSortOmp(B);
+		sw.Stop();
+		const double tSortB = sw.GetElapsedTimeMilliseconds();
+
+		size_t bytesB = n1*sizeof(std::vector<int>);
+		for (const auto& row : B) bytesB += row.capacity()*sizeof(int);
+		std::cout << "nested vectors: " << n1 + 1 << " allocations, " << bytesB/MB << " MB, init " << tInitB << " ms, sort " << tSortB << " ms" << std::endl;
+		check("Nested vectors OMP:", A, B, tsA, tInitB + tSortB);
+
+		// contiguous matrix: one aligned allocation, initialized serially like the nested vectors of
+		// the sequential reference, so the end-to-end times differ only in the layout
+		sw.Restart();
+		Matrix<int> C(n1, N);
+		for (size_t i = 0; i < n1; i++) {
+			const std::span<int> row = C[i];
+
+			for (size_t j = 0; j < row.size(); j++) row[j] = value(i, j);
+		}
+		sw.Stop();
+		const double tInitC = sw.GetElapsedTimeMilliseconds();
+		sw.Restart();
+		matrixSortSeq(C);
+		sw.Stop();
+		const double tSortC = sw.GetElapsedTimeMilliseconds();
+		std::cout << "contiguous matrix: 1 allocation, " << C.bytes()/MB << " MB (stride " << C.stride() << "), init " << tInitC << " ms, sort " << tSortC << " ms" << std::endl;
+		std::cout << std::boolalpha << "same results as nested vectors: " << same(A, C) << std::endl;
+		std::cout << "sequential end-to-end: nested " << tsA << " ms, contiguous " << tInitC + tSortC << " ms" << std::endl << std::endl;
+
+		sw.Restart();
+		Matrix<int> D(n1, N);
+		D.init([](size_t i, std::span<int> row) {
+			for (size_t j = 0; j < row.size(); j++) row[j] = value(i, j);
+		});
+		sw.Stop();
+		const double tInitD = sw.GetElapsedTimeMilliseconds();
+		sw.Restart();
+		matrixSortOmp(D);
+		sw.Stop();
+		const double tSortD = sw.GetElapsedTimeMilliseconds();
+		std::cout << "contiguous matrix: init " << tInitD << " ms, sort " << tSortD << " ms" << std::endl;
+		check("Contiguous matrix OMP:", C, D, tsA, tInitD + tSortD);
 	}
 }
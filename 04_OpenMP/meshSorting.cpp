@@ -0,0 +1,221 @@
+#include <iostream>
+#include <climits>
+#include <omp.h>
+#include <algorithm>
+#include <bit>
+#include <execution>
+#include <functional>
+#include <iomanip>
+#include <vector>
+#include <random>
+#include "Stopwatch.h"
+#include "matrix.h"
+
+constexpr size_t TileSize = 64;	// 64 x 64 ints = 16 KB per tile, source and destination tile fit in L1
+
+//////////////////////////////////////////////////////////////////////////////////////////////
+// Cache-blocked parallel transpose of the rows x cols matrix src into the cols x rows matrix dst
+// Both matrices are traversed tile by tile, so every cache line that is read or written is
+// fully used while it is in the cache.
+static void transpose(const int* src, size_t srcStride, int* dst, size_t dstStride, size_t rows, size_t cols) {
+	const size_t tileRows = (rows + TileSize - 1)/TileSize;
+	const size_t tileCols = (cols + TileSize - 1)/TileSize;
+
+	#pragma omp parallel for collapse(2) schedule(static) default(none) shared(src, dst) firstprivate(srcStride, dstStride, rows, cols, tileRows, tileCols)
+	for (size_t ti = 0; ti < tileRows; ti++) {
+		for (size_t tj = 0; tj < tileCols; tj++) {
+			const size_t iEnd = std::min(rows, (ti + 1)*TileSize);
+			const size_t jEnd = std::min(cols, (tj + 1)*TileSize);
+
+			for (size_t i = ti*TileSize; i < iEnd; i++) {
+				for (size_t j = tj*TileSize; j < jEnd; j++) {
+					dst[j*dstStride + i] = src[i*srcStride + j];
+				}
+			}
+		}
+	}
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////
+// Parallel sort of the rows [0, rows) of a matrix; in snake mode odd rows are sorted descending
+static void sortRows(int* data, size_t stride, size_t rows, size_t cols, bool snake) {
+	#pragma omp parallel for schedule(static) default(none) shared(data) firstprivate(stride, rows, cols, snake)
+	for (size_t i = 0; i < rows; i++) {
+		int* row = data + i*stride;
+
+		if (snake && (i & 1)) {
+			std::sort(row, row + cols, std::greater<int>());
+		} else {
+			std::sort(row, row + cols);
+		}
+	}
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////
+// Shearsort on an r x c mesh: ceil(log2 r) + 1 row phases in snake order, with a column phase
+// between two row phases. A column phase transposes the matrix, sorts the rows of the transposed
+// matrix and transposes back. Finally the odd rows are reversed, so the matrix is sorted in
+// row-major order.
+static void shearSort(Matrix<int>& A) {
+	const size_t r = A.rows();
+	const size_t c = A.cols();
+	const int phases = (int)std::bit_width(r - 1) + 1;
+	Matrix<int> T(c, r);
+
+	for (int phase = 0; phase < phases; phase++) {
+		sortRows(A.data(), A.stride(), r, c, true);
+		if (phase + 1 < phases) {
+			transpose(A.data(), A.stride(), T.data(), T.stride(), r, c);
+			sortRows(T.data(), T.stride(), c, r, false);
+			transpose(T.data(), T.stride(), A.data(), A.stride(), c, r);
+		}
+	}
+
+	#pragma omp parallel for schedule(static) default(none) shared(A) firstprivate(r)
+	for (size_t i = 1; i < r; i += 2) {
+		std::reverse(A[i].begin(), A[i].end());
+	}
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////
+// Number of columns s for columnsort of n elements: as many as possible with
+// r = n/s divisible by s, r even and r >= 2 (s - 1)^2 (Leighton's condition)
+static size_t columnCount(size_t n) {
+	size_t best = 1;
+
+	for (size_t s = 2; 2*(s - 1)*(s - 1) <= n/s; s++) {
+		const size_t r = n/s;
+
+		if (n % s == 0 && r % s == 0 && r % 2 == 0) best = s;
+	}
+	return best;
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////
+// Columnsort (Leighton) of v[0, n) viewed as s columns of length r stored one after another
+// 1. sort columns  2. transpose  3. sort columns  4. untranspose  5. sort columns
+// 6.-8. shift by r/2, sort columns, unshift: after step 5 every column is sorted, hence the
+//       shifted columns consist of two sorted halves and are merged in place.
+// "transpose" takes the elements in column-major order and lays them down row-major, which
+// is a transpose of the buffer viewed as an r x s matrix.
+static void columnSort(std::vector<int>& v, std::vector<int>& tmp) {
+	const size_t n = v.size();
+	const size_t s = columnCount(n);
+	const size_t r = n/s;
+
+	tmp.resize(n);
+	sortRows(v.data(), r, s, r, false);
+	if (s == 1) return;
+
+	transpose(v.data(), s, tmp.data(), r, r, s);
+	sortRows(tmp.data(), r, s, r, false);
+	transpose(tmp.data(), r, v.data(), s, s, r);
+	sortRows(v.data(), r, s, r, false);
+
+	#pragma omp parallel for schedule(static) default(none) shared(v) firstprivate(r, s)
+	for (size_t j = 0; j < s - 1; j++) {
+		const auto first = v.begin() + j*r + r/2;
+
+		std::inplace_merge(first, first + r/2, first + r);
+	}
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////
+// Columnsort of a matrix: the matrix is flattened into the columnsort buffer and the sorted
+// sequence is written back in row-major order
+static void columnSort(Matrix<int>& A) {
+	std::vector<int> v(A.rows()*A.cols());
+	std::vector<int> tmp;
+
+	#pragma omp parallel for schedule(static) default(none) shared(A, v)
+	for (size_t i = 0; i < A.rows(); i++) {
+		std::copy(A[i].begin(), A[i].end(), v.begin() + i*A.cols());
+	}
+	columnSort(v, tmp);
+	#pragma omp parallel for schedule(static) default(none) shared(A, v)
+	for (size_t i = 0; i < A.rows(); i++) {
+		std::copy_n(v.begin() + i*A.cols(), A.cols(), A[i].begin());
+	}
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////
+// Reference: flatten the matrix, sort it with the parallel STL and write it back
+static void flatSort(Matrix<int>& A) {
+	std::vector<int> v(A.rows()*A.cols());
+
+	#pragma omp parallel for schedule(static) default(none) shared(A, v)
+	for (size_t i = 0; i < A.rows(); i++) {
+		std::copy(A[i].begin(), A[i].end(), v.begin() + i*A.cols());
+	}
+	std::sort(std::execution::par, v.begin(), v.end());
+	#pragma omp parallel for schedule(static) default(none) shared(A, v)
+	for (size_t i = 0; i < A.rows(); i++) {
+		std::copy_n(v.begin() + i*A.cols(), A.cols(), A[i].begin());
+	}
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////
+// Check and print results
+static void check(const char text[], const Matrix<int>& ref, const Matrix<int>& result, double ts, double tp) {
+	static const int p = omp_get_num_procs();
+	const double S = ts/tp;
+	const double E = S/p;
+
+	std::cout << std::setw(30) << std::left << text << result.size();
+	std::cout << " in " << std::right << std::setw(7) << std::setprecision(2) << std::fixed << tp << " ms, S = " << S << ", E = " << E << std::endl;
+	std::cout << std::boolalpha << "The two operations produce the same results: " << (ref == result) << std::endl << std::endl;
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////
+static Matrix<int> randomMatrix(size_t rows, size_t cols) {
+	Matrix<int> A(rows, cols);
+
+	A.init([](size_t i, std::span<int> row) {
+		std::default_random_engine e((unsigned)i);
+		std::uniform_int_distribution<int> dist(INT_MIN, INT_MAX);
+
+		for (int& v : row) v = dist(e);
+	});
+	return A;
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////
+// Global sorting of a whole matrix in row-major order
+void meshSortingTests() {
+	std::cout << "\nMesh Sorting Tests" << std::endl;
+
+	const std::pair<size_t, size_t> shapes[] = { { 64, 65536 }, { 512, 8192 }, { 2048, 2048 } };
+	Stopwatch sw;
+
+	for (auto [rows, cols] : shapes) {
+		std::cout << "\nmatrix: " << rows << " x " << cols << ", columnsort columns: " << columnCount(rows*cols) << std::endl;
+
+		Matrix<int> ref = randomMatrix(rows, cols);
+		std::vector<int> seq(rows*cols);
+		sw.Restart();
+		for (size_t i = 0; i < rows; i++) std::copy(ref[i].begin(), ref[i].end(), seq.begin() + i*cols);
+		std::sort(seq.begin(), seq.end());
+		for (size_t i = 0; i < rows; i++) std::copy_n(seq.begin() + i*cols, cols, ref[i].begin());
+		sw.Stop();
+		const double ts = sw.GetElapsedTimeMilliseconds();
+		std::cout << "Serial flatten and sort in " << ts << " ms" << std::endl;
+
+		Matrix<int> A = randomMatrix(rows, cols);
+		sw.Restart();
+		flatSort(A);
+		sw.Stop();
+		check("Flatten and parallel sort:", ref, A, ts, sw.GetElapsedTimeMilliseconds());
+
+		Matrix<int> B = randomMatrix(rows, cols);
+		sw.Restart();
+		shearSort(B);
+		sw.Stop();
+		check("Shearsort:", ref, B, ts, sw.GetElapsedTimeMilliseconds());
+
+		Matrix<int> C = randomMatrix(rows, cols);
+		sw.Restart();
+		columnSort(C);
+		sw.Stop();
+		check("Columnsort:", ref, C, ts, sw.GetElapsedTimeMilliseconds());
+	}
+}
@@ -0,0 +1,71 @@
+#pragma once
+
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <span>
+#include <vector>
+
+//////////////////////////////////////////////////////////////////////////////////////////////
+// LSD radix sort of 32-bit signed integers with 8-bit digits: Ts = O(4 n)
+// The histograms of all four digits are computed in one pass over the data. A pass is skipped
+// if all keys have the same digit. Signed keys are handled by flipping the sign bit of the
+// most significant digit, so negative keys come first.
+// scratch must hold at least a.size() elements; it is reused by the caller across rows, so
+// sorting a row does not allocate.
+inline void radixSort(std::span<int> a, std::span<uint32_t> scratch) {
+	constexpr int Digits = 4;
+	constexpr int Buckets = 256;
+	const size_t n = a.size();
+	size_t count[Digits][Buckets] = {};
+	uint32_t* src = reinterpret_cast<uint32_t*>(a.data());
+	uint32_t* dst = scratch.data();
+
+	if (n < 2) return;
+
+	auto digit = [](uint32_t key, int d) -> uint32_t {
+		const uint32_t v = (key >> (8*d)) & 0xff;
+
+		return (d == Digits - 1) ? v ^ 0x80 : v;
+	};
+
+	for (size_t i = 0; i < n; i++) {
+		const uint32_t key = src[i];
+
+		count[0][key & 0xff]++;
+		count[1][(key >> 8) & 0xff]++;
+		count[2][(key >> 16) & 0xff]++;
+		count[3][(key >> 24) ^ 0x80]++;
+	}
+
+	for (int d = 0; d < Digits; d++) {
+		size_t offset[Buckets];
+		size_t sum = 0;
+
+		if (count[d][digit(src[0], d)] == n) continue;	// all keys have the same digit
+		for (int b = 0; b < Buckets; b++) {
+			offset[b] = sum;
+			sum += count[d][b];
+		}
+		for (size_t i = 0; i < n; i++) {
+			const uint32_t key = src[i];
+
+			dst[offset[digit(key, d)]++] = key;
+		}
+		std::swap(src, dst);
+	}
+	if (src != reinterpret_cast<uint32_t*>(a.data())) std::memcpy(a.data(), src, n*sizeof(int));
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////
+// Row-sorting engine of the matrix sorting drivers
+enum class RowSorter { StdSort, Radix };
+
+inline void sortRow(std::span<int> row, RowSorter sorter, std::vector<uint32_t>& scratch) {
+	if (sorter == RowSorter::Radix) {
+		if (scratch.size() < row.size()) scratch.resize(row.size());
+		radixSort(row, scratch);
+	} else {
+		std::sort(row.begin(), row.end());
+	}
+}
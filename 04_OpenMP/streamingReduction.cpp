@@ -0,0 +1,251 @@
+#include <algorithm>
+#include <climits>
+#include <cstdint>
+#include <cstdio>
+#include <filesystem>
+#include <fstream>
+#include <future>
+#include <iostream>
+#include <iomanip>
+#include <random>
+#include <vector>
+#include <omp.h>
+#ifndef _WIN32
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+#include "Stopwatch.h"
+
+//////////////////////////////////////////////////////////////////////////////////////////////
+// Out-of-core reductions over a binary file of 32-bit ints.
+// The file is processed in windows: while the OpenMP threads reduce the current window, the
+// next window is already being read, either by the kernel (memory-mapped windows prefetched
+// with madvise(MADV_WILLNEED), POSIX only) or by a reader thread (portable).
+
+constexpr int Bins = 256;	// equal-width histogram over the whole int range
+
+static int bin(int v) {
+	return (int)((uint32_t(v) ^ 0x80000000u) >> 24);
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////
+// Sum, minimum, maximum and histogram of a stream of ints
+struct Reduction {
+	size_t count = 0;
+	int64_t sum = 0;
+	int min = INT_MAX;
+	int max = INT_MIN;
+	std::vector<size_t> histogram = std::vector<size_t>(Bins);
+
+	// parallel reduction of one window
+	void add(const int* data, size_t n) {
+		int64_t s = 0;
+		int mn = INT_MAX, mx = INT_MIN;
+		size_t hist[Bins] = {};
+
+		#pragma omp parallel for default(none) shared(data, n) reduction(+:s, hist[:Bins]) reduction(min:mn) reduction(max:mx)
+		for (size_t i = 0; i < n; i++) {
+			const int v = data[i];
+
+			s += v;
+			mn = std::min(mn, v);
+			mx = std::max(mx, v);
+			hist[bin(v)]++;
+		}
+		count += n;
+		sum += s;
+		min = std::min(min, mn);
+		max = std::max(max, mx);
+		for (int b = 0; b < Bins; b++) histogram[b] += hist[b];
+	}
+
+	bool operator==(const Reduction& r) const {
+		return count == r.count && sum == r.sum && min == r.min && max == r.max && histogram == r.histogram;
+	}
+};
+
+//////////////////////////////////////////////////////////////////////////////////////////////
+// Portable engine: a reader thread fills the next window buffer while the current one is reduced
+static Reduction reduceReader(const std::filesystem::path& path, size_t windowBytes) {
+	const size_t window = windowBytes/sizeof(int);
+	std::ifstream in(path, std::ios::binary);
+	std::vector<int> buf[2] = { std::vector<int>(window), std::vector<int>(window) };
+	Reduction r;
+
+	auto read = [&in, window](std::vector<int>& b) {
+		in.read(reinterpret_cast<char*>(b.data()), window*sizeof(int));
+		return (size_t)in.gcount()/sizeof(int);
+	};
+
+	size_t n = read(buf[0]);
+	for (int cur = 0; n > 0; cur ^= 1) {
+		std::future<size_t> next = std::async(std::launch::async, read, std::ref(buf[cur ^ 1]));
+
+		r.add(buf[cur].data(), n);
+		n = next.get();
+	}
+	return r;
+}
+
+#ifndef _WIN32
+//////////////////////////////////////////////////////////////////////////////////////////////
+// Memory-mapped engine: windows are mapped one ahead. With prefetch the kernel is asked to
+// fault in the next window (MADV_WILLNEED) before the current window is reduced, so the disk
+// reads overlap the computation. Without prefetch only the default readahead applies.
+static Reduction reduceMmap(const std::filesystem::path& path, size_t windowBytes, bool prefetch) {
+	const int fd = open(path.c_str(), O_RDONLY);
+	Reduction r;
+
+	if (fd < 0) {
+		std::perror("open");
+		return r;
+	}
+
+	struct stat st;
+	if (fstat(fd, &st) < 0) {
+		std::perror("fstat");
+		close(fd);
+		return r;
+	}
+
+	const size_t page = (size_t)sysconf(_SC_PAGESIZE);
+	const size_t window = std::max(page, windowBytes/page*page);
+	const size_t size = (size_t)st.st_size/sizeof(int)*sizeof(int);
+
+	auto map = [&](size_t offset) -> void* {
+		if (offset >= size) return nullptr;
+
+		const size_t len = std::min(window, size - offset);
+		void* p = mmap(nullptr, len, PROT_READ, MAP_SHARED, fd, (off_t)offset);
+
+		if (p == MAP_FAILED) {
+			std::perror("mmap");
+			return nullptr;
+		}
+		madvise(p, len, MADV_SEQUENTIAL);
+		if (prefetch) madvise(p, len, MADV_WILLNEED);
+		return p;
+	};
+
+	void* cur = map(0);
+	for (size_t offset = 0; cur; offset += window) {
+		const size_t len = std::min(window, size - offset);
+		void* next = map(offset + window);
+
+		r.add(static_cast<const int*>(cur), len/sizeof(int));
+		munmap(cur, len);
+		cur = next;
+	}
+	close(fd);
+	return r;
+}
+#endif
+
+//////////////////////////////////////////////////////////////////////////////////////////////
+// Evicts the file from the page cache, so the next pass reads from disk
+static bool dropCache(const std::filesystem::path& path) {
+#ifndef _WIN32
+	const int fd = open(path.c_str(), O_RDONLY);
+
+	if (fd < 0) return false;
+	fdatasync(fd);
+	const bool ok = posix_fadvise(fd, 0, 0, POSIX_FADV_DONTNEED) == 0;
+	close(fd);
+	return ok;
+#else
+	return false;
+#endif
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////
+// Plain sequential read without computation: disk speed if the file is not cached,
+// otherwise page-cache speed
+static size_t rawRead(const std::filesystem::path& path, size_t windowBytes) {
+	std::ifstream in(path, std::ios::binary);
+	std::vector<char> buf(windowBytes);
+	size_t total = 0;
+
+	while (in.read(buf.data(), buf.size()) || in.gcount() > 0) total += (size_t)in.gcount();
+	return total;
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////
+// Check and print results
+static void check(const char text[], const Reduction& ref, const Reduction& result, size_t bytes, double t) {
+	std::cout << std::setw(30) << std::left << text << std::right << std::setw(8) << std::setprecision(2) << std::fixed << t << " ms, ";
+	std::cout << bytes/t/1e6 << " GB/s" << std::endl;
+	std::cout << std::boolalpha << "The two operations produce the same results: " << (ref == result) << std::endl;
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////
+// Streaming reductions over a generated file, with cold (evicted) and warm page cache.
+// Production files are hundreds of GB; the test file is kept small enough for a workstation.
+void streamingReductionTests() {
+	constexpr size_t FileBytes = size_t(1) << 30;
+	constexpr size_t WindowBytes = size_t(64) << 20;
+	constexpr size_t Chunk = size_t(1) << 20;
+
+	std::cout << "\nStreaming Reduction Tests" << std::endl;
+
+	const std::filesystem::path path = std::filesystem::temp_directory_path()/"progalg_streaming_reduction.bin";
+	std::default_random_engine e;
+	std::uniform_int_distribution<int> dist(INT_MIN, INT_MAX);
+	Stopwatch sw;
+	Reduction ref;
+
+	// generate the file in chunks and compute the reference on the fly
+	{
+		std::ofstream out(path, std::ios::binary);
+		std::vector<int> chunk(Chunk);
+
+		for (size_t written = 0; written < FileBytes; written += Chunk*sizeof(int)) {
+			for (int& v : chunk) v = dist(e);
+			ref.add(chunk.data(), chunk.size());
+			out.write(reinterpret_cast<const char*>(chunk.data()), chunk.size()*sizeof(int));
+		}
+		if (!out) {
+			std::cout << "cannot write " << path << std::endl;
+			return;
+		}
+	}
+	std::cout << "file: " << path << ", " << FileBytes/double(1 << 30) << " GB, window: " << (WindowBytes >> 20) << " MB" << std::endl;
+	std::cout << "sum = " << ref.sum << ", min = " << ref.min << ", max = " << ref.max << std::endl;
+
+	for (bool cold : { true, false }) {
+		auto prepare = [&]() {
+			if (cold && !dropCache(path)) std::cout << "(page cache could not be dropped)" << std::endl;
+		};
+
+		std::cout << std::endl << (cold ? "cold page cache (disk)" : "warm page cache") << std::endl;
+
+		prepare();
+		sw.Restart();
+		const size_t bytes = rawRead(path, WindowBytes);
+		sw.Stop();
+		const double tRaw = sw.GetElapsedTimeMilliseconds();
+		std::cout << std::setw(30) << std::left << "Raw read:" << std::right << std::setw(8) << std::setprecision(2) << std::fixed << tRaw << " ms, " << bytes/tRaw/1e6 << " GB/s" << std::endl;
+
+		prepare();
+		sw.Restart();
+		const Reduction r1 = reduceReader(path, WindowBytes);
+		sw.Stop();
+		check("Reader thread:", ref, r1, bytes, sw.GetElapsedTimeMilliseconds());
+
+#ifndef _WIN32
+		prepare();
+		sw.Restart();
+		const Reduction r2 = reduceMmap(path, WindowBytes, false);
+		sw.Stop();
+		check("mmap windows:", ref, r2, bytes, sw.GetElapsedTimeMilliseconds());
+
+		prepare();
+		sw.Restart();
+		const Reduction r3 = reduceMmap(path, WindowBytes, true);
+		sw.Stop();
+		check("mmap windows + WILLNEED:", ref, r3, bytes, sw.GetElapsedTimeMilliseconds());
+#endif
+	}
+	std::filesystem::remove(path);
+}
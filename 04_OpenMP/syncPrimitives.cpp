@@ -0,0 +1,337 @@
+#include <iostream>
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <filesystem>
+#include <fstream>
+#include <functional>
+#include <iomanip>
+#include <mutex>
+#include <thread>
+#include <vector>
+#include <omp.h>
+#if defined(__x86_64__) || defined(_M_X64)
+#include <immintrin.h>
+#endif
+
+//////////////////////////////////////////////////////////////////////////////////////////////
+// Hint to the processor that the thread is spinning
+static inline void cpuRelax() {
+#if defined(__x86_64__) || defined(_M_X64)
+	_mm_pause();
+#else
+	std::this_thread::yield();
+#endif
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////
+// Test and test-and-set spin lock: spins on a plain load, so waiting threads share the cache
+// line until the lock is released, and only then try to take it with an exchange
+class TTASLock {
+	std::atomic<bool> m_locked { false };
+
+public:
+	void lock() {
+		while (true) {
+			while (m_locked.load(std::memory_order_relaxed)) cpuRelax();
+			if (!m_locked.exchange(true, std::memory_order_acquire)) return;
+		}
+	}
+
+	void unlock() {
+		m_locked.store(false, std::memory_order_release);
+	}
+};
+
+//////////////////////////////////////////////////////////////////////////////////////////////
+// Ticket lock: FIFO order, every thread draws a ticket and waits until it is served
+class TicketLock {
+	alignas(64) std::atomic<uint32_t> m_next { 0 };
+	alignas(64) std::atomic<uint32_t> m_serving { 0 };
+
+public:
+	void lock() {
+		const uint32_t ticket = m_next.fetch_add(1, std::memory_order_relaxed);
+
+		while (m_serving.load(std::memory_order_acquire) != ticket) cpuRelax();
+	}
+
+	void unlock() {
+		m_serving.store(m_serving.load(std::memory_order_relaxed) + 1, std::memory_order_release);
+	}
+};
+
+//////////////////////////////////////////////////////////////////////////////////////////////
+// MCS queue lock: FIFO order, every waiting thread spins on its own queue node, so a release
+// invalidates only the cache line of the successor
+class MCSLock {
+public:
+	struct alignas(64) Node {
+		std::atomic<Node*> next { nullptr };
+		std::atomic<bool> locked { false };
+	};
+
+private:
+	std::atomic<Node*> m_tail { nullptr };
+
+public:
+	void lock(Node& node) {
+		node.next.store(nullptr, std::memory_order_relaxed);
+		node.locked.store(true, std::memory_order_relaxed);
+
+		Node* prev = m_tail.exchange(&node, std::memory_order_acq_rel);
+
+		if (prev) {
+			prev->next.store(&node, std::memory_order_release);
+			while (node.locked.load(std::memory_order_acquire)) cpuRelax();
+		}
+	}
+
+	void unlock(Node& node) {
+		Node* next = node.next.load(std::memory_order_acquire);
+
+		if (!next) {
+			Node* expected = &node;
+
+			if (m_tail.compare_exchange_strong(expected, nullptr, std::memory_order_acq_rel)) return;
+			while (!(next = node.next.load(std::memory_order_acquire))) cpuRelax();
+		}
+		next->locked.store(false, std::memory_order_release);
+	}
+};
+
+//////////////////////////////////////////////////////////////////////////////////////////////
+// Critical section of length len: len steps of a linear congruential generator on shared state
+static inline void work(uint64_t& state, int len) {
+	for (int i = 0; i < len; i++) state = state*6364136223846793005ull + 1442695040888963407ull;
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////
+// Throughput and fairness of one run
+struct RunResult {
+	double opsPerSec = 0;
+	double jain = 1;	// Jain's fairness index of the per-thread operation counts: 1 = fair, 1/p = one thread does everything
+	double minMax = 1;	// fewest over most operations of a thread
+	bool correct = true;	// the protected counter equals the number of operations
+};
+
+//////////////////////////////////////////////////////////////////////////////////////////////
+// Runs op(thread) on p threads for the given time and counts the operations per thread
+// The statistics cover the threads of the actual team, which may be smaller than p.
+template<typename Op>
+static RunResult run(int p, double seconds, Op op, const std::function<int64_t()>& total) {
+	std::vector<int64_t> ops(p);
+	double elapsed = 0;
+	int team = p;
+
+	#pragma omp parallel num_threads(p) default(none) shared(ops, elapsed, op, team) firstprivate(seconds)
+	{
+		const int t = omp_get_thread_num();
+		int64_t n = 0;
+
+		#pragma omp barrier
+		const double start = omp_get_wtime();
+		const double deadline = start + seconds;
+
+		do {
+			for (int i = 0; i < 64; i++) op(t);
+			n += 64;
+		} while (omp_get_wtime() < deadline);
+		ops[t] = n;
+
+		#pragma omp barrier
+		#pragma omp master
+		{
+			elapsed = omp_get_wtime() - start;
+			team = omp_get_num_threads();
+		}
+	}
+	ops.resize(team);
+
+	RunResult r;
+	double sum = 0, sum2 = 0;
+	int64_t mn = ops[0], mx = ops[0];
+
+	for (int64_t n : ops) {
+		sum += n;
+		sum2 += double(n)*n;
+		mn = std::min(mn, n);
+		mx = std::max(mx, n);
+	}
+	r.opsPerSec = sum/elapsed;
+	r.jain = sum*sum/(team*sum2);
+	r.minMax = double(mn)/mx;
+	r.correct = total() == (int64_t)sum;
+	return r;
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////
+// Contention benchmark of synchronization primitives protecting a shared counter.
+// Lock-based primitives execute the critical section (len steps on shared state) while holding
+// the lock; the lock-free alternatives (atomic increments and per-thread counters) need no
+// critical section, they do the same work on thread-local state.
+// There is no unified report in this repository yet; the results are written as CSV to the
+// temp directory (syncprimitives.csv: primitive, threads, cs, ops/s, jain, min/max) for later
+// aggregation.
+void syncPrimitivesTests() {
+	constexpr double Seconds = 0.1;
+	const int csLengths[] = { 0, 10, 100 };
+	const int maxThreads = omp_get_max_threads();
+
+	std::cout << "\nSynchronization Primitive Tests" << std::endl;
+
+	std::vector<int> threads;
+	for (int p = 1; p < maxThreads; p *= 2) threads.push_back(p);
+	threads.push_back(maxThreads);
+
+	const std::filesystem::path csvPath = std::filesystem::temp_directory_path()/"syncprimitives.csv";
+	std::ofstream csv(csvPath);
+	csv << "primitive,threads,cs,ops_per_s,jain,min_max" << std::endl;
+
+	for (int cs : csLengths) {
+		std::cout << "\ncritical section length = " << cs << ", throughput in Mops/s (Jain's fairness index)" << std::endl;
+		std::cout << std::setw(36) << std::left << "threads";
+		for (int p : threads) std::cout << std::setw(16) << p;
+		std::cout << std::endl;
+
+		// shared state, reset for every run
+		alignas(64) int64_t counter = 0;
+		alignas(64) uint64_t state = 1;
+		bool allCorrect = true;
+
+		auto report = [&](const char* name, auto makeOp) {
+			std::cout << std::setw(36) << std::left << name;
+			for (int p : threads) {
+				counter = 0;
+				auto [op, total] = makeOp(p);
+				const RunResult r = run(p, Seconds, op, total);
+
+				allCorrect &= r.correct;
+				std::cout << std::right << std::setw(8) << std::setprecision(2) << std::fixed << r.opsPerSec*1e-6 << " (" << r.jain << ")  " << std::left;
+				csv << name << ',' << p << ',' << cs << ',' << r.opsPerSec << ',' << r.jain << ',' << r.minMax << std::endl;
+			}
+			std::cout << std::endl;
+		};
+		auto shared = [&]() { return counter; };
+
+		// thread-local state of the lock-free alternatives
+		struct alignas(64) Padded { uint64_t value; };
+		std::vector<Padded> local(maxThreads);
+		auto localWork = [&](int t) { work(local[t].value, cs); };
+
+		report("omp critical", [&](int) {
+			return std::make_pair([&](int) {
+				#pragma omp critical
+				{
+					work(state, cs);
+					counter++;
+				}
+			}, std::function<int64_t()>(shared));
+		});
+
+		report("omp atomic", [&](int) {
+			return std::make_pair([&](int t) {
+				localWork(t);
+				#pragma omp atomic
+				counter++;
+			}, std::function<int64_t()>(shared));
+		});
+
+		omp_lock_t ompLock;
+		omp_init_lock(&ompLock);
+		report("omp_lock_t", [&](int) {
+			return std::make_pair([&](int) {
+				omp_set_lock(&ompLock);
+				work(state, cs);
+				counter++;
+				omp_unset_lock(&ompLock);
+			}, std::function<int64_t()>(shared));
+		});
+		omp_destroy_lock(&ompLock);
+
+		std::mutex mutex;
+		report("std::mutex", [&](int) {
+			return std::make_pair([&](int) {
+				std::lock_guard<std::mutex> guard(mutex);
+
+				work(state, cs);
+				counter++;
+			}, std::function<int64_t()>(shared));
+		});
+
+		std::atomic<int64_t> atomicCounter;
+		report("std::atomic fetch_add", [&](int) {
+			atomicCounter = 0;
+			return std::make_pair([&](int t) {
+				localWork(t);
+				atomicCounter.fetch_add(1, std::memory_order_relaxed);
+			}, std::function<int64_t()>([&]() { return atomicCounter.load(); }));
+		});
+
+		TTASLock ttas;
+		report("TTAS spin lock", [&](int) {
+			return std::make_pair([&](int) {
+				ttas.lock();
+				work(state, cs);
+				counter++;
+				ttas.unlock();
+			}, std::function<int64_t()>(shared));
+		});
+
+		TicketLock ticket;
+		report("ticket lock", [&](int) {
+			return std::make_pair([&](int) {
+				ticket.lock();
+				work(state, cs);
+				counter++;
+				ticket.unlock();
+			}, std::function<int64_t()>(shared));
+		});
+
+		MCSLock mcs;
+		std::vector<MCSLock::Node> nodes(maxThreads);
+		report("MCS lock", [&](int) {
+			return std::make_pair([&](int t) {
+				mcs.lock(nodes[t]);
+				work(state, cs);
+				counter++;
+				mcs.unlock(nodes[t]);
+			}, std::function<int64_t()>(shared));
+		});
+
+		std::vector<Padded> padded(maxThreads);
+		report("padded per-thread counters", [&](int p) {
+			for (Padded& c : padded) c.value = 0;
+			return std::make_pair([&](int t) {
+				localWork(t);
+				volatile uint64_t& c = padded[t].value;
+
+				c = c + 1;
+			}, std::function<int64_t()>([&, p]() {
+				int64_t sum = 0;
+
+				for (int t = 0; t < p; t++) sum += (int64_t)padded[t].value;
+				return sum;
+			}));
+		});
+
+		std::vector<int64_t> unpadded(maxThreads);
+		report("per-thread counters (false sharing)", [&](int p) {
+			std::fill(unpadded.begin(), unpadded.end(), 0);
+			return std::make_pair([&](int t) {
+				localWork(t);
+				volatile int64_t& c = unpadded[t];
+
+				c = c + 1;
+			}, std::function<int64_t()>([&, p]() {
+				int64_t sum = 0;
+
+				for (int t = 0; t < p; t++) sum += unpadded[t];
+				return sum;
+			}));
+		});
+
+		std::cout << std::boolalpha << "All primitives count correctly: " << allCorrect << " (state " << state % 1000 << ")" << std::endl;
+	}
+	std::cout << "\nresults written to " << csvPath << std::endl;
+}
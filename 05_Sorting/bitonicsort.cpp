@@ -1,11 +1,20 @@
 #include <cassert>
+#include <atomic>
+#include <thread>
 #include <omp.h>
 #include <algorithm>
+#include <bit>
+#include <functional>
+#include <limits>
 #include <vector>
 #include <iostream>
 #include <random>
+#if defined(__x86_64__) || defined(_M_X64)
+#include <immintrin.h>
+#endif
 #include "Stopwatch.h"
 #include "checkresult.h"
+#include "sort.h"
 
 using Vector = std::vector<float>;
 
@@ -159,60 +168,426 @@ void bitonicSortOMP2(float a[], const int n, const int p) {
 }
 
 //////////////////////////////////////////////////////////////////////////////////////////////////
-// compare-split of nlocal data elements
-// input: a and b
-// output: small and large
-static void compareSplit(int nlocal, float a[], float b[], float small[], float large[]) {
-	// TODO (use OMP sections)
-    // Temporary arrays to hold merged data
-    float* merged = new float[2 * nlocal];
-    
-    #pragma omp sections
-    {
-        #pragma omp section
-        {
-            // Merge the two sorted arrays
-            int i = 0, j = 0, k = 0;
-            while (i < nlocal && j < nlocal) {
-                if (a[i] <= b[j]) {
-                    merged[k++] = a[i++];
-                } else {
-                    merged[k++] = b[j++];
-                }
-            }
-            
-            // Copy any remaining elements
-            while (i < nlocal) {
-                merged[k++] = a[i++];
-            }
-            while (j < nlocal) {
-                merged[k++] = b[j++];
-            }
-        }
-    }
-	
-    
-    // Divide the merged array into "small" and "large" parts
-    #pragma omp sections
-    {
-        #pragma omp section
-        {
-            // Copy the smaller half to small[]
-            for (int i = 0; i < nlocal; i++) {
-                small[i] = merged[i];
-            }
-        }
-        
-        #pragma omp section
-        {
-            // Copy the larger half to large[]
-            for (int i = 0; i < nlocal; i++) {
-                large[i] = merged[nlocal + i];
-            }
-        }
-    }
-    
-    delete[] merged;
+// Block-based bitonic sort for p < n (used in performance tests)
+// n and p must be a power of 2
+// p parallel threads
+// compare-split steps on blocks of n/p elements, see bitonicSortBlocks in sort.h
+static void bitonicSortBlocks(float a[], const ptrdiff_t n, int p) {
+	bitonicSortBlocks(a, n, p, std::less<float>());
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// Cache-blocked bitonic sort
+// The unblocked kernels make one pass over the whole array per (i, j) stage, i.e.
+// d(d + 1)/2 passes through main memory. Here all stages with a compare-exchange distance
+// bitj < BitonicBlock are executed block by block while the block is cache-resident:
+// first every block is sorted completely (alternating direction), then every further merge
+// stage makes full passes only for the distances >= BitonicBlock and finishes the remaining
+// distances in one pass inside each block. The distances < 8 run in AVX2 registers.
+constexpr int BitonicBlock = 1 << 15;	// 128 KB of floats, fits in L2
+
+#ifdef __AVX2__
+constexpr int Lanes = 8;
+
+///////////////////////////////////////////////////////////////////////////////
+// compare-exchange of lane l with lane l ^ J inside a register
+// lane l takes the maximum if its bit J differs from the direction bit of its
+// subsequence (bit S of l, inverted for a descending network)
+template<int J, int S, bool Desc>
+static inline __m256 exchange8(__m256 v) {
+	constexpr int mask = [] {
+		int m = 0;
+		for (int l = 0; l < 8; l++) {
+			if (((l & J) != 0) != (((l & S) != 0) != Desc)) m |= 1 << l;
+		}
+		return m;
+	}();
+	const __m256 w = _mm256_permutevar8x32_ps(v, _mm256_setr_epi32(0 ^ J, 1 ^ J, 2 ^ J, 3 ^ J, 4 ^ J, 5 ^ J, 6 ^ J, 7 ^ J));
+
+	return _mm256_blend_ps(_mm256_min_ps(v, w), _mm256_max_ps(v, w), mask);
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// bitonic merge of 8 floats in a register
+template<bool Desc>
+static inline __m256 merge8(__m256 v) {
+	v = exchange8<4, 8, Desc>(v);
+	v = exchange8<2, 8, Desc>(v);
+	return exchange8<1, 8, Desc>(v);
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// bitonic sort of 8 floats in a register
+template<bool Desc>
+static inline __m256 sort8(__m256 v) {
+	v = exchange8<1, 2, Desc>(v);
+	v = exchange8<2, 4, Desc>(v);
+	v = exchange8<1, 4, Desc>(v);
+	return merge8<Desc>(v);
+}
+#else
+constexpr int Lanes = 1;
+#endif
+
+///////////////////////////////////////////////////////////////////////////////
+// compare-exchange of lo[i] with hi[i] for i < len: lo takes the min (the max if desc)
+static void compareExchange(float lo[], float hi[], const ptrdiff_t len, const bool desc) {
+	ptrdiff_t i = 0;
+
+#ifdef __AVX2__
+	for (; i + 8 <= len; i += 8) {
+		const __m256 x = _mm256_loadu_ps(lo + i);
+		const __m256 y = _mm256_loadu_ps(hi + i);
+		const __m256 mn = _mm256_min_ps(x, y);
+		const __m256 mx = _mm256_max_ps(x, y);
+
+		_mm256_storeu_ps(lo + i, desc ? mx : mn);
+		_mm256_storeu_ps(hi + i, desc ? mn : mx);
+	}
+#endif
+	for (; i < len; i++) {
+		const float x = lo[i], y = hi[i];
+
+		lo[i] = desc ? std::max(x, y) : std::min(x, y);
+		hi[i] = desc ? std::min(x, y) : std::max(x, y);
+	}
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// bitonic merge of the bitonic sequence a[0..len-1], len must be a power of 2
+static void bitonicMergeBlock(float a[], const int len, const bool desc) {
+	for (int bitj = len/2; bitj >= Lanes; bitj >>= 1) {
+		for (int k = 0; k < len; k += 2*bitj) compareExchange(a + k, a + k + bitj, bitj, desc);
+	}
+#ifdef __AVX2__
+	// distances 4, 2, 1 in registers
+	for (int k = 0; k + 8 <= len; k += 8) {
+		const __m256 v = _mm256_loadu_ps(a + k);
+
+		_mm256_storeu_ps(a + k, desc ? merge8<true>(v) : merge8<false>(v));
+	}
+#endif
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// bitonic sort of a[0..len-1] in ascending or descending order, len must be a power of 2
+// the two halves are sorted in opposite directions and the resulting bitonic sequence is merged
+static void bitonicSortBlock(float a[], const int len, const bool desc) {
+	if (len <= Lanes) {
+#ifdef __AVX2__
+		if (len == 8) {
+			const __m256 v = _mm256_loadu_ps(a);
+
+			_mm256_storeu_ps(a, desc ? sort8<true>(v) : sort8<false>(v));
+			return;
+		}
+		if (desc) std::sort(a, a + len, std::greater<float>());
+		else std::sort(a, a + len);
+#endif
+		return;
+	}
+
+	const int half = len/2;
+
+	bitonicSortBlock(a, half, false);
+	bitonicSortBlock(a + half, half, true);
+	bitonicMergeBlock(a, len, desc);
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// Cache-blocked bitonic sort (used in performance tests)
+// n must be a power of 2
+// p parallel threads
+static void bitonicSortBlocked(float a[], const int n, const int p) {
+	const int block = std::min(n, BitonicBlock);
+	const int blocks = n/block;
+
+	// stages up to sequence length block: each block is sorted, even blocks ascending, odd blocks descending
+	#pragma omp parallel for num_threads(p) schedule(static)
+	for (int b = 0; b < blocks; b++) {
+		bitonicSortBlock(a + b*block, block, (b & 1) != 0);
+	}
+
+	for (int s = 2*block; s <= n; s <<= 1) {
+		// distances >= block: one pass over the array per distance, in chunks of half a block
+		// (a chunk never crosses a run of bitj consecutive pairs)
+		for (int bitj = s/2; bitj >= block; bitj >>= 1) {
+			#pragma omp parallel for num_threads(p) schedule(static)
+			for (int c = 0; c < n/2; c += block/2) {
+				const int k = c/bitj*2*bitj + c%bitj;
+
+				compareExchange(a + k, a + k + bitj, block/2, (k & s) != 0);
+			}
+		}
+
+		// distances < block: one pass, block by block
+		#pragma omp parallel for num_threads(p) schedule(static)
+		for (int b = 0; b < blocks; b++) {
+			bitonicMergeBlock(a + b*block, block, ((b*block) & s) != 0);
+		}
+	}
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// Persistent-region bitonic sort
+// One parallel region for the whole sort: thread t owns the chunk [t*n/p, (t + 1)*n/p) of
+// channels. Stages with distance bitj < n/p stay inside the own chunk and need no
+// synchronization. A stage with bitj >= n/p pairs chunk t with chunk t ^ x (x = bitj/(n/p));
+// both threads process one half of the pairs each. Before such a stage, and before the first
+// local stage after it, the threads synchronize either with a barrier or point-to-point:
+// every thread publishes the number of the last completed stage in a flag, and waits only
+// for the threads that touched its chunks in the previous stage.
+enum class BitonicSync { Barrier, Flags };
+
+// spin-wait hint; after many spins the time slice is given away (more threads than cores)
+static inline void spinWait(const int spins) {
+#if defined(__x86_64__) || defined(_M_X64)
+	if (spins < 1024) {
+		_mm_pause();
+		return;
+	}
+#endif
+	std::this_thread::yield();
+}
+
+struct BitonicSyncStats {
+	int stages = 0;		// synchronized stages
+	double waitMs = 0;	// wait time, averaged over the threads
+};
+
+static void bitonicSortPersistent(float a[], const int n, int p, const BitonicSync sync, BitonicSyncStats& stats) {
+	struct alignas(64) Flag { std::atomic<int> stage { 0 }; };
+
+	// p must be a power of 2 with at least two channels per thread
+	p = (int)std::bit_floor((unsigned)std::clamp(p, 1, n/2));
+
+	const int d = std::bit_width((unsigned)n) - 1;
+	const int chunk = n/p;
+	std::vector<Flag> done(p);
+	std::vector<double> wait(p);
+	int synced = 0;
+	bool fullTeam = true;
+
+	#pragma omp parallel num_threads(p) default(none) shared(a, done, wait, synced, fullTeam) firstprivate(n, d, chunk, sync, p)
+	{
+		const int t = omp_get_thread_num();
+		// a smaller team (nested region, thread limit) would leave the chunks of the missing
+		// threads unsorted and wait for their flags forever: no stages, sorted after the region
+		const int stages = (omp_get_num_threads() == p) ? d : 0;
+		const int start = t*chunk;
+		int stage = 0;
+		int prevX = 0;	// partner distance of the previous stage in chunks, 0 if local
+
+		// waits until thread u has completed the given stage
+		auto waitFor = [&](int u, int s) {
+			for (int spins = 0; done[u].stage.load(std::memory_order_acquire) < s; spins++) {
+				spinWait(spins);
+			}
+		};
+
+		if (stages < d && t == 0) fullTeam = false;
+
+		int biti = 1;
+		for (int i = 0; i < stages; i++) {
+			int bitj = biti;
+
+			biti <<= 1;
+			for (int j = i; j >= 0; j--) {
+				const int x = (bitj >= chunk) ? bitj/chunk : 0;
+
+				stage++;
+				if (x || prevX) {
+					const double t0 = omp_get_wtime();
+
+					if (sync == BitonicSync::Barrier) {
+						#pragma omp barrier
+					} else {
+						// the threads that wrote or read chunk t or chunk t ^ x in the previous stage
+						waitFor(t ^ prevX, stage - 1);
+						if (x) {
+							waitFor(t ^ x, stage - 1);
+							waitFor(t ^ x ^ prevX, stage - 1);
+						}
+					}
+					wait[t] += omp_get_wtime() - t0;
+					if (t == 0) synced++;
+				}
+
+				if (x) {
+					// pairs between chunk t and chunk t ^ x: the lower thread takes the first half
+					const int lower = (t & ~x)*chunk;
+					const int half = (t & x) ? chunk/2 : 0;
+
+					compareExchange(a + lower + half, a + lower + half + bitj, chunk/2, (lower & biti) != 0);
+				} else {
+					for (int k = start; k < start + chunk; k += 2*bitj) {
+						compareExchange(a + k, a + k + bitj, bitj, (k & biti) != 0);
+					}
+				}
+				done[t].stage.store(stage, std::memory_order_release);
+				prevX = x;
+				bitj >>= 1;
+			}
+		}
+	}
+	stats.stages = synced;
+	stats.waitMs = 0;
+	for (double w : wait) stats.waitMs += w*1000/p;
+	if (!fullTeam) bitonicSortBlocked(a, n, p);
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// Fork/join cost of one stage of bitonicSortOMP2: an empty parallel region
+static double forkJoinMs(const int p, const int stages) {
+	int count = 0;
+	const double t0 = omp_get_wtime();
+
+	for (int s = 0; s < stages; s++) {
+		omp_set_num_threads(p);
+		#pragma omp parallel
+		{
+			#pragma omp atomic
+			count++;
+		}
+	}
+	return (omp_get_wtime() - t0)*1000/stages;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// Bitonic sort for arbitrary n
+// The array is treated as the first n elements of a virtual array of length bit_ceil(n)
+// padded with +inf. The network is the variant where all comparators are ascending: every
+// merge of a block of length s starts with a flip (channel base + o is compared with channel
+// base + s - 1 - o) followed by half-cleaners. A comparator with a virtual partner would keep
+// the smaller element on the lower channel, so it is a no-op and is skipped: no padding is
+// allocated and no work is spent on it.
+
+///////////////////////////////////////////////////////////////////////////////
+// flip step of the block [base, base + s), offsets o in [from, to) of the lower half
+static void bitonicFlip(float a[], const ptrdiff_t base, const ptrdiff_t s, const ptrdiff_t n, const ptrdiff_t from, const ptrdiff_t to) {
+	ptrdiff_t o = std::max(from, base + s - n);
+
+#ifdef __AVX2__
+	const __m256i reverse = _mm256_setr_epi32(7, 6, 5, 4, 3, 2, 1, 0);
+
+	for (; o + 8 <= to; o += 8) {
+		float* x = a + base + o;
+		float* y = a + base + s - 8 - o;	// y[7] is the partner of x[0]
+		const __m256 vx = _mm256_loadu_ps(x);
+		const __m256 vy = _mm256_permutevar8x32_ps(_mm256_loadu_ps(y), reverse);
+
+		_mm256_storeu_ps(x, _mm256_min_ps(vx, vy));
+		_mm256_storeu_ps(y, _mm256_permutevar8x32_ps(_mm256_max_ps(vx, vy), reverse));
+	}
+#endif
+	for (; o < to; o++) {
+		float& x = a[base + o];
+		float& y = a[base + s - 1 - o];
+
+		if (y < x) std::swap(x, y);
+	}
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// half-cleaner with distance bitj on the block [base, base + len), restricted to channels < n
+static void bitonicHalfCleaner(float a[], const ptrdiff_t base, const ptrdiff_t len, const ptrdiff_t bitj, const ptrdiff_t n) {
+	for (ptrdiff_t k = base; k < base + len && k + bitj < n; k += 2*bitj) {
+		compareExchange(a + k, a + k + bitj, std::min(bitj, n - k - bitj), false);
+	}
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// ascending sort of the block [base, base + len), restricted to channels < n
+// a complete block uses the cache-blocked kernel, the ragged last block the flip network
+static void bitonicSortAnyBlock(float a[], const ptrdiff_t base, const ptrdiff_t len, const ptrdiff_t n) {
+	if (base + len <= n) {
+		bitonicSortBlock(a + base, len, false);
+		return;
+	}
+	for (ptrdiff_t s = 2; s <= len; s <<= 1) {
+		for (ptrdiff_t b = base; b < n; b += s) {
+			bitonicFlip(a, b, s, n, 0, s/2);
+			for (ptrdiff_t bitj = s/4; bitj > 0; bitj >>= 1) bitonicHalfCleaner(a, b, s, bitj, n);
+		}
+	}
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// half-cleaners with distances < len on the block [base, base + len), restricted to channels < n
+static void bitonicMergeAnyBlock(float a[], const ptrdiff_t base, const ptrdiff_t len, const ptrdiff_t n) {
+	if (base + len <= n) {
+		bitonicMergeBlock(a + base, len, false);
+		return;
+	}
+	for (ptrdiff_t bitj = len/2; bitj > 0; bitj >>= 1) bitonicHalfCleaner(a, base, len, bitj, n);
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// Sequential bitonic sort for arbitrary n
+// same blocking as bitonicSortBlocked: the blocks are sorted in the cache, larger merges
+// make full passes only for the flip and the distances >= BitonicBlock
+static void bitonicSortAnySeq(float a[], const ptrdiff_t n) {
+	const ptrdiff_t N = (ptrdiff_t)std::bit_ceil((size_t)n);
+	const ptrdiff_t block = std::min<ptrdiff_t>(N, BitonicBlock);
+
+	for (ptrdiff_t base = 0; base < n; base += block) bitonicSortAnyBlock(a, base, block, n);
+
+	for (ptrdiff_t s = 2*block; s <= N; s <<= 1) {
+		for (ptrdiff_t base = 0; base < n; base += s) bitonicFlip(a, base, s, n, 0, s/2);
+		for (ptrdiff_t bitj = s/4; bitj >= block; bitj >>= 1) bitonicHalfCleaner(a, 0, N, bitj, n);
+		for (ptrdiff_t base = 0; base < n; base += block) bitonicMergeAnyBlock(a, base, block, n);
+	}
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// Parallel bitonic sort for arbitrary n
+// p parallel threads
+// The blocks are distributed among the threads; the flip and the half-cleaners with
+// distances >= BitonicBlock are distributed in chunks of half a block.
+void bitonicSortAnyOMP(float a[], const ptrdiff_t n, const int p) {
+	const ptrdiff_t N = (ptrdiff_t)std::bit_ceil((size_t)n);
+	const ptrdiff_t block = std::min<ptrdiff_t>(N, BitonicBlock);
+	const ptrdiff_t chunk = std::max<ptrdiff_t>(1, block/2);
+
+	#pragma omp parallel num_threads(p) default(none) shared(a) firstprivate(n, N, block, chunk)
+	{
+		#pragma omp for schedule(static)
+		for (ptrdiff_t base = 0; base < n; base += block) {
+			bitonicSortAnyBlock(a, base, block, n);
+		}
+
+		for (ptrdiff_t s = 2*block; s <= N; s <<= 1) {
+			#pragma omp for schedule(static)
+			for (ptrdiff_t c = 0; c < N/2; c += chunk) {
+				const ptrdiff_t o = c%(s/2);
+
+				bitonicFlip(a, c/(s/2)*s, s, n, o, o + chunk);
+			}
+			for (ptrdiff_t bitj = s/4; bitj >= block; bitj >>= 1) {
+				#pragma omp for schedule(static)
+				for (ptrdiff_t c = 0; c < N/2; c += chunk) {
+					const ptrdiff_t k = c/bitj*2*bitj + c%bitj;
+
+					if (k + bitj < n) compareExchange(a + k, a + k + bitj, std::min(chunk, n - k - bitj), false);
+				}
+			}
+			#pragma omp for schedule(static)
+			for (ptrdiff_t base = 0; base < n; base += block) {
+				bitonicMergeAnyBlock(a, base, block, n);
+			}
+		}
+	}
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// Number of passes over the whole array: unblocked kernels and cache-blocked kernel
+static std::pair<int, int> bitonicPasses(const int n) {
+	const int d = std::bit_width((unsigned)n) - 1;
+	const int b = std::bit_width((unsigned)std::min(n, BitonicBlock)) - 1;
+	int blocked = 1;
+
+	for (int i = b + 1; i <= d; i++) blocked += i - b + 1;
+	return { d*(d + 1)/2, blocked };
 }
 
 ///////////////////////////////////////////////////////////////////////////////
@@ -235,6 +610,9 @@ void bitonicsortTests(int n) {
 	std::cout << "p = " << p << std::endl;
 	std::cout << "Max Threads: " << omp_get_max_threads() << std::endl;
 
+	const auto [passes, blockedPasses] = bitonicPasses(n);
+	std::cout << "Passes over the array: " << passes << " (unblocked), " << blockedPasses << " (cache-blocked)" << std::endl;
+
 	// stl sort
 	sw.Start();
 	std::sort(sortRef.begin(), sortRef.end());
@@ -263,4 +641,103 @@ void bitonicsortTests(int n) {
 	bitonicSortOMP2(sort.data(), n, p);
 	sw.Stop();
 	check("parallel bitonic sort (p < n):", sortRef.data(), sort.data(), ts, sw.GetElapsedTimeMilliseconds(), n, p);
+
+	// block-based bitonic sort with compare-split
+	copy(data.begin(), data.end(), sort.begin());
+	p = omp_get_num_procs();
+	sw.Restart();
+	bitonicSortBlocks(sort.data(), n, p);
+	sw.Stop();
+	check("block bitonic sort (split):", sortRef.data(), sort.data(), ts, sw.GetElapsedTimeMilliseconds(), n, p);
+
+	// cache-blocked bitonic sort
+	copy(data.begin(), data.end(), sort.begin());
+	sw.Restart();
+	bitonicSortBlocked(sort.data(), n, p);
+	sw.Stop();
+	check("cache-blocked bitonic sort:", sortRef.data(), sort.data(), ts, sw.GetElapsedTimeMilliseconds(), n, p);
+
+	// parallel sample sort
+	copy(data.begin(), data.end(), sort.begin());
+	sw.Restart();
+	sampleSort(sort.data(), n, p);
+	sw.Stop();
+	check("parallel sample sort:", sortRef.data(), sort.data(), ts, sw.GetElapsedTimeMilliseconds(), n, p);
+
+	// parallel radix sort
+	copy(data.begin(), data.end(), sort.begin());
+	sw.Restart();
+	radixSort(sort.data(), n, p);
+	sw.Stop();
+	check("parallel radix sort:", sortRef.data(), sort.data(), ts, sw.GetElapsedTimeMilliseconds(), n, p);
+
+	// persistent parallel region: synchronization overhead per stage
+	std::cout << "fork/join per stage (p < n version): " << std::setprecision(4) << forkJoinMs(8, passes)*1000 << " us, " << passes << " stages" << std::endl;
+	for (auto [name, sync] : { std::pair("persistent bitonic sort (barriers):", BitonicSync::Barrier), std::pair("persistent bitonic sort (flags):", BitonicSync::Flags) }) {
+		BitonicSyncStats stats;
+
+		copy(data.begin(), data.end(), sort.begin());
+		sw.Restart();
+		bitonicSortPersistent(sort.data(), n, p, sync, stats);
+		sw.Stop();
+		check(name, sortRef.data(), sort.data(), ts, sw.GetElapsedTimeMilliseconds(), n, p);
+		std::cout << "synchronized stages: " << stats.stages << ", wait per stage: " << std::setprecision(4) << (stats.stages ? stats.waitMs*1000/stats.stages : 0) << " us" << std::endl;
+	}
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// Bitonic sort of arbitrary n compared to padding the input to the next power of 2
+void bitonicsortAnyTests(size_t n) {
+	std::cout << "\nBitonic Sort Tests (arbitrary n)" << std::endl;
+	Stopwatch sw;
+	std::default_random_engine e;
+	std::uniform_real_distribution<float> dist;
+	Vector data(n);
+	Vector sortRef(n);
+	Vector sort(n);
+
+	// init arrays
+	for (size_t i = 0; i < n; i++) sortRef[i] = data[i] = dist(e);
+	const int p = omp_get_num_procs();
+	const size_t N = std::bit_ceil(n);
+
+	std::cout << std::endl;
+	std::cout << "n = " << n << ", next power of 2 = " << N << std::endl;
+	std::cout << "p = " << p << std::endl;
+
+	// stl sort
+	sw.Start();
+	std::sort(sortRef.begin(), sortRef.end());
+	sw.Stop();
+	const double ts = sw.GetElapsedTimeMilliseconds();
+	check("std::sort:", sortRef.data(), sortRef.data(), ts, ts, n, p);
+
+	// padding with +inf to the next power of 2 (allocation and copies included)
+	// the power-of-2 kernels have int indices
+	if (N <= (size_t)std::numeric_limits<int>::max()) {
+		sw.Restart();
+		{
+			Vector padded(N, std::numeric_limits<float>::infinity());
+
+			copy(data.begin(), data.end(), padded.begin());
+			bitonicSortBlocked(padded.data(), (int)N, p);
+			copy(padded.begin(), padded.begin() + n, sort.begin());
+		}
+		sw.Stop();
+		check("padded cache-blocked bitonic:", sortRef.data(), sort.data(), ts, sw.GetElapsedTimeMilliseconds(), n, p);
+	}
+
+	// sequential bitonic sort
+	copy(data.begin(), data.end(), sort.begin());
+	sw.Restart();
+	bitonicSortAnySeq(sort.data(), (ptrdiff_t)n);
+	sw.Stop();
+	check("sequential bitonic sort:", sortRef.data(), sort.data(), ts, sw.GetElapsedTimeMilliseconds(), n, p);
+
+	// parallel bitonic sort
+	copy(data.begin(), data.end(), sort.begin());
+	sw.Restart();
+	bitonicSortAnyOMP(sort.data(), (ptrdiff_t)n, p);
+	sw.Stop();
+	check("parallel bitonic sort:", sortRef.data(), sort.data(), ts, sw.GetElapsedTimeMilliseconds(), n, p);
 }
@@ -0,0 +1,118 @@
+#pragma once
+
+#include <algorithm>
+#include <bit>
+#include <cmath>
+#include <cstdint>
+#include <random>
+#include <vector>
+
+//////////////////////////////////////////////////////////////////////////////////////////////
+// Input distributions for the sorting benchmarks
+enum class Distribution { Uniform, Sorted, Reverse, OrganPipe, FewUnique, AllEqual, Zipf, Sawtooth, NearlySorted };
+
+constexpr Distribution Distributions[] = {
+	Distribution::Uniform, Distribution::Sorted, Distribution::Reverse, Distribution::OrganPipe, Distribution::FewUnique,
+	Distribution::AllEqual, Distribution::Zipf, Distribution::Sawtooth, Distribution::NearlySorted
+};
+
+constexpr int FewUniqueValues = 16;
+constexpr int SawtoothTeeth = 64;
+constexpr double ZipfExponent = 1.0;
+constexpr size_t ZipfUniverse = 1 << 20;	// distinct values, exactly representable as floats
+constexpr double NearlySortedSwaps = 0.01;	// fraction of elements swapped with a random partner
+
+//////////////////////////////////////////////////////////////////////////////////////////////
+// i-th float above 1: strictly increasing in i and exact for i < 2^30, whereas (float)i
+// collapses neighbouring integers into duplicates above 2^24
+inline float orderedValue(size_t i) {
+	return std::bit_cast<float>(uint32_t(0x3f800000u + i));
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////
+inline const char* distributionName(Distribution d) {
+	switch (d) {
+	case Distribution::Uniform: return "uniform";
+	case Distribution::Sorted: return "sorted";
+	case Distribution::Reverse: return "reverse";
+	case Distribution::OrganPipe: return "organ pipe";
+	case Distribution::FewUnique: return "few unique";
+	case Distribution::AllEqual: return "all equal";
+	case Distribution::Zipf: return "zipf";
+	case Distribution::Sawtooth: return "sawtooth";
+	case Distribution::NearlySorted: return "nearly sorted";
+	}
+	return "";
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////
+// n floats of distribution d
+// uniform: uniform in [0, 1)
+// sorted, reverse: v(0), v(1), .., v(n - 1) and v(n), v(n - 1), .., v(1) with v = orderedValue,
+//                 so all values are distinct for n < 2^30
+// organ pipe: ascending to n/2, then descending
+// few unique: FewUniqueValues distinct values in random order
+// all equal: 0.5
+// zipf: rank r of ZipfUniverse values is drawn with probability ~ 1/r^ZipfExponent; the ranks
+//       are scattered over the value range, so the frequent values are not the smallest
+// sawtooth: SawtoothTeeth ascending runs of equal length
+// nearly sorted: sorted, then NearlySortedSwaps*n elements swapped with a random partner
+inline std::vector<float> generateInput(Distribution d, size_t n, unsigned seed = 0) {
+	std::default_random_engine e(seed);
+	std::vector<float> v(n);
+
+	switch (d) {
+	case Distribution::Uniform: {
+		std::uniform_real_distribution<float> dist;
+
+		for (float& x : v) x = dist(e);
+		break;
+	}
+	case Distribution::Sorted:
+		for (size_t i = 0; i < n; i++) v[i] = orderedValue(i);
+		break;
+	case Distribution::Reverse:
+		for (size_t i = 0; i < n; i++) v[i] = orderedValue(n - i);
+		break;
+	case Distribution::OrganPipe:
+		for (size_t i = 0; i < n; i++) v[i] = orderedValue(std::min(i, n - i));
+		break;
+	case Distribution::FewUnique: {
+		std::uniform_int_distribution<int> dist(0, FewUniqueValues - 1);
+
+		for (float& x : v) x = (float)dist(e);
+		break;
+	}
+	case Distribution::AllEqual:
+		std::fill(v.begin(), v.end(), 0.5f);
+		break;
+	case Distribution::Zipf: {
+		// inverse transform sampling on the cumulative distribution of the ranks
+		std::vector<double> cdf(ZipfUniverse);
+		std::uniform_real_distribution<double> dist;
+		double sum = 0;
+
+		for (size_t r = 0; r < ZipfUniverse; r++) cdf[r] = sum += 1/std::pow((double)(r + 1), ZipfExponent);
+		for (float& x : v) {
+			const size_t r = std::lower_bound(cdf.begin(), cdf.end(), dist(e)*sum) - cdf.begin();
+
+			x = (float)((std::min(r, ZipfUniverse - 1)*2654435761u) % ZipfUniverse);
+		}
+		break;
+	}
+	case Distribution::Sawtooth: {
+		const size_t tooth = std::max<size_t>(1, n/SawtoothTeeth);
+
+		for (size_t i = 0; i < n; i++) v[i] = orderedValue(i % tooth);
+		break;
+	}
+	case Distribution::NearlySorted: {
+		std::uniform_int_distribution<size_t> dist(0, n - 1);
+
+		for (size_t i = 0; i < n; i++) v[i] = orderedValue(i);
+		for (size_t k = 0; n > 0 && k < (size_t)(NearlySortedSwaps*n); k++) std::swap(v[dist(e)], v[dist(e)]);
+		break;
+	}
+	}
+	return v;
+}
@@ -0,0 +1,427 @@
+#include <omp.h>
+#include <algorithm>
+#include <cstdint>
+#include <filesystem>
+#include <fstream>
+#include <functional>
+#include <future>
+#include <limits>
+#include <memory>
+#include <string>
+#include <vector>
+#include <iostream>
+#include <iomanip>
+#include <random>
+#ifndef _WIN32
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+#include "Stopwatch.h"
+#include "sort.h"
+
+//////////////////////////////////////////////////////////////////////////////////////////////
+// External (out-of-core) parallel sort of a binary file of floats
+// 1. Run generation: the input is read in chunks that fit in the memory budget, every chunk
+//    is sorted in parallel by the radix sort and written as a sorted run. The write is
+//    asynchronous: while a run is written, the next chunk is read and sorted in a second buffer.
+// 2. k-way merge: a loser tree selects the smallest head of k runs with log k comparisons per
+//    element. Every run is read through two buffers: while the merge consumes one, the next
+//    block is read ahead into the other; the output is written the same way. If there are
+//    more runs than buffers fit in memory, groups of runs are merged into longer runs first.
+// All sizes and positions are size_t, so inputs are not limited to 2^31 elements.
+constexpr size_t MergeMinBlock = size_t(1) << 16;	// minimum floats per merge buffer if the budget allows (256 KB)
+
+//////////////////////////////////////////////////////////////////////////////////////////////
+// Sequential reader of a run: the next block is read ahead by a reader thread
+class RunReader {
+	std::ifstream m_in;
+	std::vector<float> m_buf[2];
+	std::future<size_t> m_next;
+	size_t m_size = 0;	// elements in the current buffer
+	size_t m_pos = 0;	// next element in the current buffer
+	int m_cur = 0;
+
+	size_t read(std::vector<float>& b) {
+		m_in.read(reinterpret_cast<char*>(b.data()), b.size()*sizeof(float));
+		return (size_t)m_in.gcount()/sizeof(float);
+	}
+
+	void readAhead() {
+		m_next = std::async(std::launch::async, &RunReader::read, this, std::ref(m_buf[m_cur ^ 1]));
+	}
+
+public:
+	RunReader(const std::filesystem::path& path, size_t block)
+		: m_in(path, std::ios::binary), m_buf{ std::vector<float>(block), std::vector<float>(block) }
+	{
+		m_size = read(m_buf[0]);
+		readAhead();
+	}
+
+	RunReader(const RunReader&) = delete;
+	RunReader& operator=(const RunReader&) = delete;
+
+	// next element of the run, false at the end of the run
+	bool next(float& x) {
+		if (m_pos == m_size) {
+			if (m_size == 0) return false;
+			m_size = m_next.get();
+			m_pos = 0;
+			m_cur ^= 1;
+			if (m_size == 0) return false;
+			readAhead();
+		}
+		x = m_buf[m_cur][m_pos++];
+		return true;
+	}
+};
+
+//////////////////////////////////////////////////////////////////////////////////////////////
+// Sequential writer: a full buffer is written by a writer thread while the other one is filled
+class RunWriter {
+	std::ofstream m_out;
+	std::vector<float> m_buf[2];
+	std::future<void> m_pending;
+	size_t m_pos = 0;
+	int m_cur = 0;
+
+	void flush() {
+		if (m_pending.valid()) m_pending.get();
+		m_pending = std::async(std::launch::async, [this, b = m_cur, n = m_pos]() {
+			m_out.write(reinterpret_cast<const char*>(m_buf[b].data()), n*sizeof(float));
+		});
+		m_cur ^= 1;
+		m_pos = 0;
+	}
+
+public:
+	RunWriter(const std::filesystem::path& path, size_t block)
+		: m_out(path, std::ios::binary), m_buf{ std::vector<float>(block), std::vector<float>(block) }
+	{}
+
+	RunWriter(const RunWriter&) = delete;
+	RunWriter& operator=(const RunWriter&) = delete;
+
+	void push(float x) {
+		m_buf[m_cur][m_pos++] = x;
+		if (m_pos == m_buf[m_cur].size()) flush();
+	}
+
+	// writes the rest and closes the file, returns false on a write error
+	bool close() {
+		if (m_pos > 0) flush();
+		if (m_pending.valid()) m_pending.get();
+
+		const bool ok = m_out.good();
+
+		m_out.close();
+		return ok;
+	}
+};
+
+//////////////////////////////////////////////////////////////////////////////////////////////
+// Loser tree over the heads of k runs
+// The leaves k..2k - 1 are the runs, every inner node 1..k - 1 holds the loser of the match
+// played there and node 0 the overall winner. Replacing the winner's head replays only the
+// matches on the path from its leaf to the root: log k comparisons, no data-dependent
+// restructuring as in a heap.
+class LoserTree {
+	std::vector<int> m_node;	// m_node[0]: winner, m_node[1..k - 1]: losers
+	std::vector<float> m_key;	// current head of every run
+	std::vector<char> m_done;	// run exhausted: loses every match
+	int m_k;
+
+	bool beats(int a, int b) const {
+		return !m_done[a] && (m_done[b] || m_key[a] < m_key[b]);
+	}
+
+public:
+	LoserTree(const std::vector<float>& keys, const std::vector<char>& done)
+		: m_node(keys.size()), m_key(keys), m_done(done), m_k((int)keys.size())
+	{
+		std::vector<int> winner(2*m_k);
+
+		for (int i = 0; i < m_k; i++) winner[m_k + i] = i;
+		for (int t = m_k - 1; t > 0; t--) {
+			int a = winner[2*t], b = winner[2*t + 1];
+
+			if (beats(b, a)) std::swap(a, b);
+			winner[t] = a;
+			m_node[t] = b;
+		}
+		m_node[0] = winner[1];
+	}
+
+	bool empty() const { return m_done[m_node[0]]; }
+	int winner() const { return m_node[0]; }
+	float top() const { return m_key[m_node[0]]; }
+
+	// replaces the head of the winner's run (or marks the run exhausted) and replays its path
+	void replace(float key, bool done) {
+		int s = m_node[0];
+
+		m_key[s] = key;
+		m_done[s] = done;
+		for (int t = (s + m_k)/2; t > 0; t /= 2) {
+			if (beats(m_node[t], s)) std::swap(m_node[t], s);
+		}
+		m_node[0] = s;
+	}
+};
+
+//////////////////////////////////////////////////////////////////////////////////////////////
+// merges the sorted runs into output with buffers of block floats; returns false on an error
+static bool mergeRuns(const std::vector<std::filesystem::path>& runs, const std::filesystem::path& output, size_t block) {
+	const size_t k = runs.size();
+	std::vector<std::unique_ptr<RunReader>> readers;
+	std::vector<float> heads(k);
+	std::vector<char> done(k);
+	RunWriter out(output, block);
+
+	for (size_t r = 0; r < k; r++) {
+		readers.push_back(std::make_unique<RunReader>(runs[r], block));
+		done[r] = !readers[r]->next(heads[r]);
+	}
+
+	if (k > 0) {
+		LoserTree tree(heads, done);
+		float x = 0;
+
+		while (!tree.empty()) {
+			out.push(tree.top());
+
+			const bool end = !readers[tree.winner()]->next(x);
+
+			tree.replace(x, end);
+		}
+	}
+	return out.close();
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////
+// Statistics of one external sort
+struct ExternalSortStats {
+	size_t n = 0;		// elements
+	size_t runs = 0;	// initial runs
+	int passes = 0;		// merge passes
+	double runMs = 0;	// run generation
+	double mergeMs = 0;	// all merge passes
+};
+
+//////////////////////////////////////////////////////////////////////////////////////////////
+// External sort of the file input into the file output with p threads and a memory budget of
+// memory bytes; the runs are written to the directory of the output. Returns false on an I/O error.
+// Run generation holds two chunks and the scratch buffer of the radix sort, hence the chunks
+// are a third of the budget. A merge pass holds two buffers per run and two for the output:
+// 2(k + 1) buffers for k runs. The fan-in is capped so the buffers keep at least MergeMinBlock
+// floats, the buffers always share the budget.
+static bool externalSort(const std::filesystem::path& input, const std::filesystem::path& output, size_t memory, int p, ExternalSortStats& stats) {
+	const size_t chunk = std::max<size_t>(1, memory/(3*sizeof(float)));
+	const size_t maxFanIn = std::max<size_t>(2, memory/(2*sizeof(float)*MergeMinBlock) - 1);
+	auto mergeBlock = [memory](size_t k) { return std::max<size_t>(1, memory/(2*sizeof(float)*(k + 1))); };
+	const std::filesystem::path dir = output.parent_path();
+	std::vector<std::filesystem::path> runs;
+	size_t nextRun = 0;
+	Stopwatch sw;
+	bool ok = true;
+
+	auto runPath = [&]() {
+		return dir/("progalg_run_" + std::to_string(nextRun++) + ".bin");
+	};
+
+	// run generation
+	sw.Start();
+	{
+		std::ifstream in(input, std::ios::binary);
+		std::vector<float> buf[2] = { std::vector<float>(chunk), std::vector<float>(chunk) };
+		std::future<bool> pending;
+
+		if (!in) return false;
+		stats.n = 0;
+		for (int cur = 0; ; cur ^= 1) {
+			in.read(reinterpret_cast<char*>(buf[cur].data()), chunk*sizeof(float));
+
+			const size_t len = (size_t)in.gcount()/sizeof(float);
+
+			if (len == 0) break;
+			stats.n += len;
+			radixSort(buf[cur].data(), len, p);
+			if (pending.valid()) ok &= pending.get();
+			runs.push_back(runPath());
+			pending = std::async(std::launch::async, [&b = buf[cur], len, path = runs.back()]() {
+				std::ofstream out(path, std::ios::binary);
+
+				out.write(reinterpret_cast<const char*>(b.data()), len*sizeof(float));
+				return out.good();
+			});
+		}
+		if (pending.valid()) ok &= pending.get();
+	}
+	sw.Stop();
+	stats.runMs = sw.GetElapsedTimeMilliseconds();
+	stats.runs = runs.size();
+
+	// merge passes: groups of maxFanIn runs, until one pass produces the output
+	sw.Restart();
+	stats.passes = 0;
+	while (ok && runs.size() > maxFanIn) {
+		std::vector<std::filesystem::path> merged;
+
+		for (size_t r = 0; r < runs.size(); r += maxFanIn) {
+			const std::vector<std::filesystem::path> group(runs.begin() + r, runs.begin() + std::min(runs.size(), r + maxFanIn));
+
+			merged.push_back(runPath());
+			ok &= mergeRuns(group, merged.back(), mergeBlock(group.size()));
+			for (const auto& run : group) std::filesystem::remove(run);
+		}
+		runs = std::move(merged);
+		stats.passes++;
+	}
+	if (ok) {
+		ok = mergeRuns(runs, output, mergeBlock(runs.size()));
+		stats.passes++;
+	}
+	for (const auto& run : runs) std::filesystem::remove(run);
+	sw.Stop();
+	stats.mergeMs = sw.GetElapsedTimeMilliseconds();
+	return ok;
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////
+// Evicts the file from the page cache, so the next pass reads from disk
+static bool dropCache(const std::filesystem::path& path) {
+#ifndef _WIN32
+	const int fd = open(path.c_str(), O_RDONLY);
+
+	if (fd < 0) return false;
+	fdatasync(fd);
+	const bool ok = posix_fadvise(fd, 0, 0, POSIX_FADV_DONTNEED) == 0;
+	close(fd);
+	return ok;
+#else
+	return false;
+#endif
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////
+// Order-independent fingerprint of a multiset of floats
+struct Fingerprint {
+	size_t count = 0;
+	uint64_t sum = 0;
+	uint64_t sum2 = 0;
+
+	void add(const float* data, size_t n) {
+		for (size_t i = 0; i < n; i++) {
+			const uint64_t k = radixKey(data[i]);
+
+			sum += k;
+			sum2 += k*k;
+		}
+		count += n;
+	}
+
+	bool operator==(const Fingerprint& f) const {
+		return count == f.count && sum == f.sum && sum2 == f.sum2;
+	}
+};
+
+//////////////////////////////////////////////////////////////////////////////////////////////
+// External sort of n random floats with a memory budget of memory bytes
+// The disk bandwidth is measured with a sequential write and a cold read of the input file.
+// Every merge pass reads and writes the whole data once more, so the sort moves
+// (passes + 1) times the input in each direction; the disk bound is the time this takes at
+// the measured bandwidth. Runs written shortly before they are merged may still be in the
+// page cache, which can make the sort faster than the disk bound.
+void externalSortTests(size_t n, size_t memory) {
+	constexpr size_t Chunk = size_t(1) << 20;
+
+	std::cout << "\nExternal Sort Tests" << std::endl;
+
+	const std::filesystem::path dir = std::filesystem::temp_directory_path();
+	const std::filesystem::path input = dir/"progalg_external_input.bin";
+	const std::filesystem::path output = dir/"progalg_external_output.bin";
+	const int p = omp_get_num_procs();
+	const double bytes = double(n*sizeof(float));
+	std::default_random_engine e;
+	std::uniform_real_distribution<float> dist;
+	Stopwatch sw;
+	Fingerprint ref;
+	double writeMs = 0;
+
+	// generate the input file in chunks
+	{
+		std::ofstream out(input, std::ios::binary);
+		std::vector<float> chunk(Chunk);
+
+		for (size_t written = 0; written < n; written += chunk.size()) {
+			chunk.resize(std::min(Chunk, n - written));
+			for (float& v : chunk) v = dist(e);
+			ref.add(chunk.data(), chunk.size());
+			sw.Restart();
+			out.write(reinterpret_cast<const char*>(chunk.data()), chunk.size()*sizeof(float));
+			sw.Stop();
+			writeMs += sw.GetElapsedTimeMilliseconds();
+		}
+		out.flush();
+		if (!out) {
+			std::cout << "cannot write " << input << std::endl;
+			return;
+		}
+	}
+	sw.Restart();
+	if (!dropCache(input)) std::cout << "(page cache could not be dropped)" << std::endl;	// includes the write back
+	sw.Stop();
+	writeMs += sw.GetElapsedTimeMilliseconds();
+
+	// cold sequential read
+	double readMs = 0;
+	{
+		std::ifstream in(input, std::ios::binary);
+		std::vector<char> buf(Chunk*sizeof(float));
+
+		sw.Restart();
+		while (in.read(buf.data(), buf.size()) || in.gcount() > 0) {}
+		sw.Stop();
+		readMs = sw.GetElapsedTimeMilliseconds();
+	}
+	dropCache(input);
+
+	std::cout << "n = " << n << " (" << std::setprecision(2) << std::fixed << bytes/double(1 << 30) << " GB), memory = " << (memory >> 20) << " MB" << std::endl;
+	std::cout << "p = " << p << std::endl;
+	std::cout << "disk write " << bytes/writeMs/1e6 << " GB/s, read " << bytes/readMs/1e6 << " GB/s" << std::endl << std::endl;
+
+	ExternalSortStats stats;
+	sw.Restart();
+	const bool ok = externalSort(input, output, memory, p, stats);
+	sw.Stop();
+	const double t = sw.GetElapsedTimeMilliseconds();
+
+	if (!ok) {
+		std::cout << "external sort failed (I/O error)" << std::endl;
+	} else {
+		// verify: sorted and the same multiset as the input
+		std::ifstream in(output, std::ios::binary);
+		std::vector<float> buf(Chunk);
+		Fingerprint result;
+		bool sorted = true;
+		float last = -std::numeric_limits<float>::infinity();
+
+		while (in.read(reinterpret_cast<char*>(buf.data()), buf.size()*sizeof(float)) || in.gcount() > 0) {
+			const size_t len = (size_t)in.gcount()/sizeof(float);
+
+			sorted &= last <= buf[0] && std::is_sorted(buf.begin(), buf.begin() + len);
+			last = buf[len - 1];
+			result.add(buf.data(), len);
+		}
+
+		const double diskMs = (stats.passes + 1)*(readMs + writeMs);
+
+		std::cout << std::setw(30) << std::left << "run generation:" << " in " << std::right << std::setw(8) << stats.runMs << " ms, " << stats.runs << " runs" << std::endl;
+		std::cout << std::setw(30) << std::left << "merge:" << " in " << std::right << std::setw(8) << stats.mergeMs << " ms, " << stats.passes << " passes" << std::endl;
+		std::cout << std::setw(30) << std::left << "external sort:" << " in " << std::right << std::setw(8) << t << " ms, ";
+		std::cout << bytes/t/1e6 << " GB/s, disk bound " << diskMs << " ms (" << 100*diskMs/t << "% of disk bandwidth)" << std::endl;
+		std::cout << std::boolalpha << "output is correctly sorted: " << (sorted && result == ref) << std::endl;
+	}
+	std::filesystem::remove(input);
+	std::filesystem::remove(output);
+}
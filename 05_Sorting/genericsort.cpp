@@ -0,0 +1,179 @@
+#include <omp.h>
+#include <cstdint>
+#include <algorithm>
+#include <functional>
+#include <span>
+#include <utility>
+#include <vector>
+#include <iostream>
+#include <random>
+#include "Stopwatch.h"
+#include "checkresult.h"
+#include "sort.h"
+
+////////////////////////////////////////////////////////////////////////////////////////
+// record of a table: sort key and row id
+struct Record {
+	float key;
+	uint32_t row;
+};
+
+////////////////////////////////////////////////////////////////////////////////////////
+// Check and print results of a key-value sort
+// keys must be sorted, and keys[i] must be the original key of row rows[i] for a permutation rows
+template<typename K>
+static void checkPairs(const char text[], const std::vector<K>& original, const std::vector<K>& keys, const std::vector<uint32_t>& rows, double ts, double tp, unsigned p, bool stable) {
+	const size_t n = keys.size();
+	const double S = ts/tp;
+	const double E = S/p;
+	std::vector<bool> seen(n);
+	bool consistent = std::is_sorted(keys.begin(), keys.end());
+	bool isStable = true;
+
+	for (size_t i = 0; i < n && consistent; i++) {
+		consistent = rows[i] < n && !seen[rows[i]] && original[rows[i]] == keys[i];
+		if (!consistent) break;
+		seen[rows[i]] = true;
+		if (i > 0 && keys[i - 1] == keys[i] && rows[i - 1] > rows[i]) isStable = false;
+	}
+
+	std::cout << std::setw(30) << std::left << text;
+	std::cout << " in " << std::right << std::setw(8) << std::setprecision(2) << std::fixed << tp << " ms, S = " << S << ", E = " << E << std::endl;
+	std::cout << std::boolalpha << "keys are sorted and payloads follow their keys: " << consistent;
+	if (stable) std::cout << ", stable: " << isStable;
+	std::cout << std::endl;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////
+// Generic sorting library: other element types, records and key-value pairs
+void genericSortTests(size_t n) {
+	std::cout << "\nGeneric Sort Tests" << std::endl;
+	Stopwatch sw;
+	std::default_random_engine e;
+	const int p = omp_get_num_procs();
+
+	std::cout << std::endl;
+	std::cout << "n = " << n << std::endl;
+	std::cout << "p = " << p << std::endl << std::endl;
+
+	// 64-bit integers with all algorithms
+	{
+		std::uniform_int_distribution<int64_t> dist(-(int64_t(1) << 40), int64_t(1) << 40);
+		std::vector<int64_t> data(n), ref(n), a(n);
+
+		for (size_t i = 0; i < n; i++) ref[i] = data[i] = dist(e);
+		sw.Start();
+		std::sort(ref.begin(), ref.end());
+		sw.Stop();
+		const double ts = sw.GetElapsedTimeMilliseconds();
+		check("int64 std::sort:", ref.data(), ref.data(), ts, ts, n, p);
+
+		auto run = [&](const char* text, auto sort) {
+			std::copy(data.begin(), data.end(), a.begin());
+			sw.Restart();
+			sort(std::span(a));
+			sw.Stop();
+			check(text, ref.data(), a.data(), ts, sw.GetElapsedTimeMilliseconds(), n, p);
+		};
+		run("int64 quicksort:", [](std::span<int64_t> s) { quicksort(s); });
+		run("int64 block quicksort:", [](std::span<int64_t> s) { blockQuicksort(s); });
+		run("int64 parallel quicksort:", [p](std::span<int64_t> s) { parallelQuicksort(s, p); });
+		run("int64 par. quicksort (blocks):", [p](std::span<int64_t> s) { parallelQuicksortBlocks(s, p); });
+		run("int64 bitonic sort:", [p](std::span<int64_t> s) { bitonicSort(s, p); });
+		run("int64 bitonic sort (blocks):", [p](std::span<int64_t> s) { bitonicSortBlocks(s, p); });
+		run("int64 sample sort:", [p](std::span<int64_t> s) { sampleSort(s, p); });
+		run("int64 parallelSort (radix):", [p](std::span<int64_t> s) { parallelSort(s, p); });
+	}
+
+	// floats: the radix fast path compared to the comparator-based path
+	{
+		std::uniform_real_distribution<float> dist(-1, 1);
+		std::vector<float> data(n), ref(n), a(n);
+
+		for (size_t i = 0; i < n; i++) ref[i] = data[i] = dist(e);
+		sw.Restart();
+		std::sort(ref.begin(), ref.end());
+		sw.Stop();
+		const double ts = sw.GetElapsedTimeMilliseconds();
+
+		std::copy(data.begin(), data.end(), a.begin());
+		sw.Restart();
+		parallelSort(std::span(a), p);
+		sw.Stop();
+		check("float parallelSort (radix):", ref.data(), a.data(), ts, sw.GetElapsedTimeMilliseconds(), n, p);
+
+		std::copy(data.begin(), data.end(), a.begin());
+		sw.Restart();
+		parallelSort(std::span(a), p, [](float x, float y) { return x < y; });
+		sw.Stop();
+		check("float parallelSort (lambda):", ref.data(), a.data(), ts, sw.GetElapsedTimeMilliseconds(), n, p);
+	}
+
+	// records sorted by key, and the same data as separate key and row id arrays
+	{
+		std::uniform_int_distribution<size_t> dist(0, n/4);	// duplicate keys
+		std::vector<Record> data(n), ref(n), a(n);
+		std::vector<float> original(n), keys(n);
+		std::vector<uint32_t> rows(n);
+		const auto key = [](const Record& r) { return r.key; };
+
+		for (size_t i = 0; i < n; i++) {
+			original[i] = (float)dist(e);
+			ref[i] = data[i] = { original[i], (uint32_t)i };
+		}
+		sw.Restart();
+		std::sort(ref.begin(), ref.end(), byKey(key));
+		sw.Stop();
+		const double ts = sw.GetElapsedTimeMilliseconds();
+
+		auto split = [&](const std::vector<Record>& r) {
+			for (size_t i = 0; i < n; i++) {
+				keys[i] = r[i].key;
+				rows[i] = r[i].row;
+			}
+		};
+		split(ref);
+		checkPairs("records std::sort by key:", original, keys, rows, ts, ts, p, false);
+
+		std::copy(data.begin(), data.end(), a.begin());
+		sw.Restart();
+		parallelSortBy(std::span(a), p, key);
+		sw.Stop();
+		split(a);
+		checkPairs("records parallelSortBy:", original, keys, rows, ts, sw.GetElapsedTimeMilliseconds(), p, false);
+
+		std::copy(data.begin(), data.end(), a.begin());
+		sw.Restart();
+		blockQuicksort(std::span(a), byKey(key));
+		sw.Stop();
+		split(a);
+		checkPairs("records block quicksort:", original, keys, rows, ts, sw.GetElapsedTimeMilliseconds(), p, false);
+
+		// float keys: packed 64-bit key|index words
+		keys = original;
+		for (size_t i = 0; i < n; i++) rows[i] = (uint32_t)i;
+		sw.Restart();
+		sortPairs(std::span(keys), std::span(rows), p);
+		sw.Stop();
+		checkPairs("sortPairs float (packed):", original, keys, rows, ts, sw.GetElapsedTimeMilliseconds(), p, true);
+
+		// double keys: (key, index) pairs
+		std::vector<double> originalD(original.begin(), original.end());
+		std::vector<double> keysD = originalD;
+		for (size_t i = 0; i < n; i++) rows[i] = (uint32_t)i;
+		sw.Restart();
+		sortPairs(std::span(keysD), std::span(rows), p);
+		sw.Stop();
+		checkPairs("sortPairs double:", originalD, keysD, rows, ts, sw.GetElapsedTimeMilliseconds(), p, false);
+
+		// composite keys without radix image: indices sorted by the sample sort
+		std::vector<std::pair<float, int>> originalP(n);
+		for (size_t i = 0; i < n; i++) originalP[i] = { original[i], -(int)i };
+		std::vector<std::pair<float, int>> keysP = originalP;
+		for (size_t i = 0; i < n; i++) rows[i] = (uint32_t)i;
+		sw.Restart();
+		sortPairs(std::span(keysP), std::span(rows), p);
+		sw.Stop();
+		checkPairs("sortPairs pair:", originalP, keysP, rows, ts, sw.GetElapsedTimeMilliseconds(), p, false);
+	}
+}
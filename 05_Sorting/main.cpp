@@ -1,13 +1,25 @@
+#include <cstddef>
+
 ////////////////////////////////////////////////////////////////////////////////////////
 // global variables, prototypes
 void bitonicsortTests(int n);
-void quicksortTests(int n);
+void bitonicsortAnyTests(size_t n);
+void quicksortTests(size_t n);
+void quicksortAdversarialTests();
+void genericSortTests(size_t n);
+void sortBenchmarkTests(size_t n);
+void externalSortTests(size_t n, size_t memory);
 
 ////////////////////////////////////////////////////////////////////////////////////////
 int main() {
 	// speed measurements
 	for (int i = 15; i <= 27; i += 3) {
 		bitonicsortTests(1 << i);
+		bitonicsortAnyTests((1 << i) + 1);
 		quicksortTests(1 << i);
+		sortBenchmarkTests(1 << i);
 	}
+	quicksortAdversarialTests();
+	genericSortTests(1 << 22);
+	externalSortTests(size_t(1) << 28, size_t(256) << 20);
 }
\ No newline at end of file
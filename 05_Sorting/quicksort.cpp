@@ -2,122 +2,53 @@
 #include <omp.h>
 #include <cstdlib>
 #include <cstring>
+#include <cstdint>
+#include <atomic>
+#include <functional>
+#include <utility>
 #include <algorithm>
+#include <bit>
+#include <numeric>
 #include <vector>
 #include <iostream>
 #include <random>
 #include "Stopwatch.h"
 #include "checkresult.h"
+#include "distributions.h"
+#include "sort.h"
 
 using Vector = std::vector<float>;
 
 ////////////////////////////////////////////////////////////////////////////////////////
-// compiler directives
-//#define _RANDOMPIVOT_ // random pivot chosing is too slow
-
-#ifndef _RANDOMPIVOT_
-////////////////////////////////////////////////////////////////////////////////////////
-// determine median of a[p1], a[p2], and a[p3]
-static int median(float a[], int p1, int p2, int p3) {
-	const float ap1 = a[p1];
-	const float ap2 = a[p2];
-	const float ap3 = a[p3];
-
-	if (ap1 <= ap2) {
-		return (ap2 <= ap3) ? p2 : ((ap1 <= ap3) ? p3 : p1);
-	} else {
-		return (ap1 <= ap3) ? p1 : ((ap2 <= ap3) ? p3 : p2);
-	}
+// serial quicksort
+// sorts a[left]..a[right]
+void quicksort(float a[], ptrdiff_t left, ptrdiff_t right) {
+	quicksort(a, left, right, std::less<float>());
 }
-#endif
 
 ////////////////////////////////////////////////////////////////////////////////////////
-// serial quicksort
+// serial block quicksort with depth limit 2 log(n)
 // sorts a[left]..a[right]
-void quicksort(float a[], int left, int right) {
-	// compute pivot
-#ifdef _RANDOMPIVOT_
-	std::default_random_engine e;
-	std::uniform_int_distribution dist(left, right);
-
-	const size_t pivotPos = dist(e);
-#else
-	const size_t pivotPos = median(a, left, left + (right - left)/2, right);
-#endif
-	const float pivot = a[pivotPos];
-
-	int i = left, j = right;
-
-	do {
-		while (a[i] < pivot) i++;
-		while (pivot < a[j]) j--;
-		if (i <= j) {
-			std::swap(a[i], a[j]);
-			i++;
-			j--;
-		}
-	} while (i <= j);
-	if (left < j) quicksort(a, left, j);
-	if (i < right) quicksort(a, i, right);
+void blockQuicksort(float a[], ptrdiff_t left, ptrdiff_t right) {
+	blockQuicksort(a, left, right, std::less<float>());
 }
 
 ////////////////////////////////////////////////////////////////////////////////////////
 // parallel quicksort
 // sorts a[left]..a[right] using p threads 
-void parallelQuicksort(float a[], int left, int right, int p) {
-	assert(p > 0);
-	assert(left >= 0 && left <= right);
-	// TODO use OMP
-
-	// Base case: use serial quicksort if array is small or only one thread available
-	if (p <= 1 || (right - left) <= 1000) {
-		quicksort(a, left, right);
-		return;
-	}
-	
-	// Compute pivot position using the median function
-	const size_t pivotPos = median(a, left, left + (right - left)/2, right);
-	const float pivot = a[pivotPos];
-	
-	// Partition the array like in serial quicksort
-	int i = left, j = right;
-	do {
-		while (a[i] < pivot) i++;
-		while (pivot < a[j]) j--;
-		if (i <= j) {
-			std::swap(a[i], a[j]);
-			i++;
-			j--;
-		}
-	} while (i <= j);
-	
-	// Split threads between partitions
-	int leftThreads = p / 2;
-	int rightThreads = p - leftThreads;
-	
-	// Initialize OpenMP parallel region if we're at the top level
-	#pragma omp parallel num_threads(p) if(p > 1 && omp_get_thread_num() == 0)
-	{
-		#pragma omp single nowait
-		{
-			// Create tasks for recursive calls
-			if (left < j) {
-				#pragma omp task
-				parallelQuicksort(a, left, j, leftThreads);
-			}
-			
-			if (i < right) {
-				#pragma omp task
-				parallelQuicksort(a, i, right, rightThreads);
-			}
-			
-			#pragma omp taskwait
-		}
-	}
+void parallelQuicksort(float a[], ptrdiff_t left, ptrdiff_t right, int p) {
+	parallelQuicksort(a, left, right, p, std::less<float>());
 }
 
 ////////////////////////////////////////////////////////////////////////////////////////
-void quicksortTests(int n) {
+// parallel quicksort with parallel partitioning
+// sorts a[left]..a[right] using p threads
+void parallelQuicksortBlocks(float a[], ptrdiff_t left, ptrdiff_t right, int p) {
+	parallelQuicksortBlocks(a, left, right, p, std::less<float>());
+}
+
+////////////////////////////////////////////////////////////////////////////////////////
+void quicksortTests(size_t n) {
 	std::cout << "\nQuicksort Tests" << std::endl;
 	Stopwatch sw;
 	std::default_random_engine e;
@@ -150,14 +81,161 @@ void quicksortTests(int n) {
 	// sequential quicksort
 	copy(data.begin(), data.end(), sort.begin());
 	sw.Restart();
-	quicksort(sort.data(), 0, n - 1);
+	quicksort(sort.data(), 0, (ptrdiff_t)n - 1);
 	sw.Stop();
 	check("sequential quicksort:", sortRef.data(), sort.data(), ts, sw.GetElapsedTimeMilliseconds(), n, p);
 
+	// sequential block quicksort
+	copy(data.begin(), data.end(), sort.begin());
+	sw.Restart();
+	blockQuicksort(sort.data(), 0, (ptrdiff_t)n - 1);
+	sw.Stop();
+	check("sequential block quicksort:", sortRef.data(), sort.data(), ts, sw.GetElapsedTimeMilliseconds(), n, p);
+
 	// parallel quicksort
 	copy(data.begin(), data.end(), sort.begin());
 	sw.Restart();
-	parallelQuicksort(sort.data(), 0, n - 1, p);
+	parallelQuicksort(sort.data(), 0, (ptrdiff_t)n - 1, p);
 	sw.Stop();
 	check("parallel quicksort:", sortRef.data(), sort.data(), ts, sw.GetElapsedTimeMilliseconds(), n, p);
-}
\ No newline at end of file
+
+	// parallel quicksort with parallel partition
+	copy(data.begin(), data.end(), sort.begin());
+	sw.Restart();
+	parallelQuicksortBlocks(sort.data(), 0, (ptrdiff_t)n - 1, p);
+	sw.Stop();
+	check("parallel quicksort (blocks):", sortRef.data(), sort.data(), ts, sw.GetElapsedTimeMilliseconds(), n, p);
+
+	// parallel sample sort
+	copy(data.begin(), data.end(), sort.begin());
+	sw.Restart();
+	sampleSort(sort.data(), n, p);
+	sw.Stop();
+	check("parallel sample sort:", sortRef.data(), sort.data(), ts, sw.GetElapsedTimeMilliseconds(), n, p);
+
+	// parallel radix sort
+	copy(data.begin(), data.end(), sort.begin());
+	sw.Restart();
+	radixSort(sort.data(), n, p);
+	sw.Stop();
+	check("parallel radix sort:", sortRef.data(), sort.data(), ts, sw.GetElapsedTimeMilliseconds(), n, p);
+
+	// speedup curves
+	std::cout << "threads   S parallel quicksort   S with parallel partition" << std::endl;
+	for (int q = 1; q <= p; q *= 2) {
+		copy(data.begin(), data.end(), sort.begin());
+		sw.Restart();
+		parallelQuicksort(sort.data(), 0, (ptrdiff_t)n - 1, q);
+		sw.Stop();
+		const double t1 = sw.GetElapsedTimeMilliseconds();
+
+		copy(data.begin(), data.end(), sort.begin());
+		sw.Restart();
+		parallelQuicksortBlocks(sort.data(), 0, (ptrdiff_t)n - 1, q);
+		sw.Stop();
+		const double t2 = sw.GetElapsedTimeMilliseconds();
+
+		std::cout << std::setw(7) << q << std::setw(23) << ts/t1 << std::setw(28) << ts/t2 << std::endl;
+	}
+}
+
+////////////////////////////////////////////////////////////////////////////////////////
+// Median-of-three killer for quicksort (McIlroy's adversary)
+// The algorithm of quicksort runs on indices. All values start as "gas" (larger than any
+// fixed value); when two gas values are compared, one of them is fixed to the next smallest
+// value, preferring the current pivot candidate. The fixed values are consistent with all
+// answers given, so quicksort takes the same quadratic path on the resulting input.
+static Vector medianOf3Killer(int n) {
+	const int gas = n;
+	std::vector<int> val(n, gas);
+	std::vector<int> idx(n);
+	std::vector<std::pair<int, int>> stack { { 0, n - 1 } };
+	int solid = 0, candidate = -1;
+
+	std::iota(idx.begin(), idx.end(), 0);
+
+	auto less = [&](int x, int y) {
+		if (val[x] == gas && val[y] == gas) {
+			if (x == candidate) val[x] = solid++;
+			else val[y] = solid++;
+		}
+		if (val[x] == gas) candidate = x;
+		else if (val[y] == gas) candidate = y;
+		return val[x] < val[y];
+	};
+	auto lessEqual = [&](int x, int y) { return !less(y, x); };
+
+	while (!stack.empty()) {
+		const auto [left, right] = stack.back();
+		const int p1 = left, p2 = left + (right - left)/2, p3 = right;
+		int pivotPos;
+
+		stack.pop_back();
+		if (lessEqual(idx[p1], idx[p2])) {
+			pivotPos = lessEqual(idx[p2], idx[p3]) ? p2 : (lessEqual(idx[p1], idx[p3]) ? p3 : p1);
+		} else {
+			pivotPos = lessEqual(idx[p1], idx[p3]) ? p1 : (lessEqual(idx[p2], idx[p3]) ? p3 : p2);
+		}
+
+		const int pivot = idx[pivotPos];
+		int i = left, j = right;
+
+		do {
+			while (less(idx[i], pivot)) i++;
+			while (less(pivot, idx[j])) j--;
+			if (i <= j) {
+				std::swap(idx[i], idx[j]);
+				i++;
+				j--;
+			}
+		} while (i <= j);
+		// same order as the recursion: left part first
+		if (i < right) stack.push_back({ i, right });
+		if (left < j) stack.push_back({ left, j });
+	}
+
+	Vector v(n);
+	for (int k = 0; k < n; k++) v[k] = (float)((val[k] == gas) ? solid++ : val[k]);
+	return v;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////
+// Serial quicksorts on random and adversarial inputs
+// Block quicksort must not fall back to heapsort on any of these inputs.
+void quicksortAdversarialTests() {
+	constexpr int n = 1 << 14;	// the killer input makes quicksort quadratic and its recursion n/2 deep
+
+	std::cout << "\nQuicksort Adversarial Tests" << std::endl;
+	std::cout << "n = " << n << ", times in ms" << std::endl << std::endl;
+
+	const std::pair<const char*, Vector> inputs[] = {
+		{ "random", generateInput(Distribution::Uniform, n) }, { "sorted", generateInput(Distribution::Sorted, n) },
+		{ "reverse", generateInput(Distribution::Reverse, n) }, { "all equal", generateInput(Distribution::AllEqual, n) },
+		{ "organ pipe", generateInput(Distribution::OrganPipe, n) }, { "median-of-3 killer", medianOf3Killer(n) }
+	};
+	Stopwatch sw;
+
+	std::cout << std::setw(20) << std::left << "input" << std::right << std::setw(12) << "std::sort" << std::setw(12) << "quicksort" << std::setw(16) << "block quicksort" << std::setw(12) << "heapsorted" << std::endl;
+	for (const auto& [name, data] : inputs) {
+		Vector ref = data, a = data, b = data;
+		size_t heapsorted = 0;	// elements sorted by the heapsort fallback of block quicksort
+
+		sw.Restart();
+		std::sort(ref.begin(), ref.end());
+		sw.Stop();
+		const double ts = sw.GetElapsedTimeMilliseconds();
+
+		sw.Restart();
+		quicksort(a.data(), 0, n - 1);
+		sw.Stop();
+		const double tq = sw.GetElapsedTimeMilliseconds();
+
+		sw.Restart();
+		blockQuicksort(b.data(), 0, n - 1, std::less<float>(), &heapsorted);
+		sw.Stop();
+		const double tb = sw.GetElapsedTimeMilliseconds();
+
+		std::cout << std::setw(20) << std::left << name << std::right << std::setprecision(2) << std::fixed << std::setw(12) << ts << std::setw(12) << tq << std::setw(16) << tb << std::setw(12) << heapsorted;
+		std::cout << std::boolalpha << "   correctly sorted: " << (a == ref && b == ref) << ", no fallback: " << (heapsorted == 0) << std::endl;
+	}
+}
@@ -0,0 +1,220 @@
+#pragma once
+
+#include <algorithm>
+#include <bit>
+#include <climits>
+#include <cstdint>
+#include <limits>
+#include <type_traits>
+#include <vector>
+#include <omp.h>
+
+//////////////////////////////////////////////////////////////////////////////////////////////
+// Parallel radix sort
+// For floats the sort works on the order-preserving bit pattern of the floats: the sign bit is flipped
+// for positive numbers and all bits are flipped for negative numbers, then unsigned integer
+// order is float order. The keys are computed on the fly from the stored floats.
+// Hybrid MSD/LSD: the top level distributes all elements in parallel by the 8 most
+// significant bits in which the keys differ (MSD). Buckets that fit in L2 are sorted by LSD
+// passes over the remaining differing bits; larger buckets are distributed again by the next
+// 8 bits. Large scatters go through software write-combining buffers: every bucket collects
+// a cache line of elements before it is written, which cuts TLB and cache misses when 256
+// output streams are written at once.
+constexpr int RadixBits = 8;
+constexpr int RadixBuckets = 1 << RadixBits;
+constexpr size_t RadixCacheBytes = 256 << 10;	// buckets up to 256 KB are sorted by LSD passes
+constexpr size_t RadixSmall = 64;		// smaller buckets are sorted with std::sort
+
+//////////////////////////////////////////////////////////////////////////////////////////////
+// order-preserving unsigned key of a float
+inline uint32_t radixKey(float x) {
+	const uint32_t u = std::bit_cast<uint32_t>(x);
+
+	return u ^ ((uint32_t)((int32_t)u >> 31) | 0x80000000u);
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////
+// The sort is generic in the element type T and the key extractor key(x), which returns an
+// unsigned integer (32 or 64 bits) in the order of the elements. Elements with equal keys
+// keep no particular order.
+template<typename KeyFn, typename T>
+using RadixKeyType = std::invoke_result_t<KeyFn, const T&>;
+
+template<typename K>
+inline uint32_t radixDigit(K key, int shift) {
+	return (uint32_t)(key >> shift) & (RadixBuckets - 1);
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////
+// number of low key bits in which the keys of a[0..n-1] differ
+template<typename T, typename KeyFn>
+int radixDifferingBits(const T a[], size_t n, KeyFn key) {
+	using K = RadixKeyType<KeyFn, T>;
+	K mn = std::numeric_limits<K>::max(), mx = 0;
+
+	for (size_t i = 0; i < n; i++) {
+		const K k = key(a[i]);
+
+		mn = std::min(mn, k);
+		mx = std::max(mx, k);
+	}
+	return (n > 0) ? std::bit_width(K(mn ^ mx)) : 0;
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////
+// scatters src[0..n-1] by digit to dst[pos[digit]++] through write-combining buffers
+template<typename T, typename KeyFn>
+void radixScatter(const T src[], size_t n, int shift, T dst[], size_t pos[], KeyFn key) {
+	constexpr int Line = std::max<int>(1, 64/sizeof(T));	// elements per write-combining buffer
+	alignas(64) T wc[RadixBuckets][Line];
+	int fill[RadixBuckets] = {};
+
+	for (size_t i = 0; i < n; i++) {
+		const uint32_t d = radixDigit(key(src[i]), shift);
+
+		wc[d][fill[d]++] = src[i];
+		if (fill[d] == Line) {
+			std::copy_n(wc[d], Line, dst + pos[d]);
+			pos[d] += Line;
+			fill[d] = 0;
+		}
+	}
+	for (int d = 0; d < RadixBuckets; d++) {
+		std::copy_n(wc[d], fill[d], dst + pos[d]);
+		pos[d] += fill[d];
+	}
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////
+// Serial hybrid radix sort of a bucket: the data is in a[0..n-1], b is scratch space of n
+// elements, and the result ends in b if toB is set, otherwise in a
+template<typename T, typename KeyFn>
+void radixSortBucket(T a[], T b[], size_t n, bool toB, KeyFn key) {
+	if (n <= RadixSmall) {
+		std::sort(a, a + n, [&key](const T& x, const T& y) { return key(x) < key(y); });
+		if (toB) std::copy(a, a + n, b);
+		return;
+	}
+
+	const int bits = radixDifferingBits(a, n, key);
+
+	if (n*sizeof(T) <= RadixCacheBytes || bits <= RadixBits) {
+		// LSD passes over the differing bits, all histograms in one pass
+		const int passes = (bits + RadixBits - 1)/RadixBits;
+		std::vector<size_t> count(passes*RadixBuckets);
+		T* src = a;
+		T* dst = b;
+
+		for (size_t i = 0; i < n; i++) {
+			const auto k = key(a[i]);
+
+			for (int d = 0; d < passes; d++) count[d*RadixBuckets + radixDigit(k, d*RadixBits)]++;
+		}
+		for (int d = 0; d < passes; d++) {
+			size_t* pos = count.data() + d*RadixBuckets;
+			size_t sum = 0;
+
+			for (int k = 0; k < RadixBuckets; k++) {
+				const size_t c = pos[k];
+
+				pos[k] = sum;
+				sum += c;
+			}
+			for (size_t i = 0; i < n; i++) dst[pos[radixDigit(key(src[i]), d*RadixBits)]++] = src[i];
+			std::swap(src, dst);
+		}
+		// src holds the result
+		if ((src == b) != toB) std::copy(src, src + n, toB ? b : a);
+		return;
+	}
+
+	// MSD: distribute by the top 8 differing bits, then sort every bucket
+	const int shift = bits - RadixBits;
+	size_t bounds[RadixBuckets + 1] = {};
+	size_t pos[RadixBuckets];
+
+	for (size_t i = 0; i < n; i++) bounds[radixDigit(key(a[i]), shift) + 1]++;
+	for (int k = 0; k < RadixBuckets; k++) bounds[k + 1] += bounds[k];
+	std::copy(bounds, bounds + RadixBuckets, pos);
+	radixScatter(a, n, shift, b, pos, key);
+	for (int k = 0; k < RadixBuckets; k++) {
+		radixSortBucket(b + bounds[k], a + bounds[k], bounds[k + 1] - bounds[k], !toB, key);
+	}
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////
+// Parallel radix sort of a[0..n-1] by key with p threads
+// Top level: parallel min/max of the keys, per-thread histograms of the top differing digit,
+// exclusive scan bucket by bucket and thread by thread, parallel write-combined scatter into
+// a buffer. Then the buckets are sorted in parallel back into a.
+template<typename T, typename KeyFn>
+void radixSort(T a[], size_t n, int p, KeyFn key) {
+	static_assert(std::is_trivially_copyable_v<T>, "radixSort requires trivially copyable elements");
+	using K = RadixKeyType<KeyFn, T>;
+	static_assert(std::is_unsigned_v<K>, "the radix key must be an unsigned integer");
+
+	std::vector<T> buf(n);
+	K mn = std::numeric_limits<K>::max(), mx = 0;
+
+	if (p <= 1 || n*sizeof(T) <= RadixCacheBytes) {
+		radixSortBucket(a, buf.data(), n, false, key);
+		return;
+	}
+
+	#pragma omp parallel for num_threads(p) default(none) shared(a, key) firstprivate(n) reduction(min:mn) reduction(max:mx)
+	for (size_t i = 0; i < n; i++) {
+		const K k = key(a[i]);
+
+		mn = std::min(mn, k);
+		mx = std::max(mx, k);
+	}
+
+	const int bits = std::bit_width(K(mn ^ mx));
+	if (bits == 0) return;
+
+	const int shift = std::max(0, bits - RadixBits);
+	std::vector<size_t> offsets(p*RadixBuckets);	// per thread and bucket: count, then scatter position
+	std::vector<size_t> bounds(RadixBuckets + 1);
+
+	#pragma omp parallel num_threads(p) default(none) shared(a, buf, offsets, bounds, key) firstprivate(n, shift)
+	{
+		const int q = omp_get_num_threads();	// the team may be smaller than p (nested region, thread limit)
+		const int t = omp_get_thread_num();
+		const size_t begin = n*t/q;
+		const size_t end = n*(t + 1)/q;
+		size_t* pos = offsets.data() + t*RadixBuckets;
+
+		for (size_t i = begin; i < end; i++) pos[radixDigit(key(a[i]), shift)]++;
+		#pragma omp barrier
+
+		#pragma omp single
+		{
+			size_t sum = 0;
+
+			for (int k = 0; k < RadixBuckets; k++) {
+				bounds[k] = sum;
+				for (int u = 0; u < q; u++) {
+					const size_t c = offsets[u*RadixBuckets + k];
+
+					offsets[u*RadixBuckets + k] = sum;
+					sum += c;
+				}
+			}
+			bounds[RadixBuckets] = sum;
+		}
+
+		radixScatter(a + begin, end - begin, shift, buf.data(), pos, key);
+		#pragma omp barrier
+
+		#pragma omp for schedule(dynamic, 1)
+		for (int k = 0; k < RadixBuckets; k++) {
+			radixSortBucket(buf.data() + bounds[k], a + bounds[k], bounds[k + 1] - bounds[k], true, key);
+		}
+	}
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////
+// Parallel radix sort of floats
+inline void radixSort(float a[], size_t n, int p) {
+	radixSort(a, n, p, [](float x) { return radixKey(x); });
+}
@@ -0,0 +1,200 @@
+#pragma once
+
+#include <algorithm>
+#include <bit>
+#include <cstdint>
+#include <functional>
+#include <random>
+#include <vector>
+#include <omp.h>
+
+//////////////////////////////////////////////////////////////////////////////////////////////
+// Parallel sample sort (super scalar sample sort)
+// A sorted random sample of Oversampling*k elements yields k - 1 splitters. Every element is
+// classified into one of k buckets by a branchless search in the splitter tree, the buckets
+// are counted per thread, the exclusive scan of the counts (bucket by bucket, thread by
+// thread) gives every thread its scatter offsets, and the elements are scattered into a
+// buffer of n elements. The buckets are then sorted in parallel, recursively with the same
+// scheme and the roles of array and buffer swapped, until they fit in L1.
+// The order is given by a strict weak ordering comp (default operator<).
+constexpr size_t SampleSortBase = 1 << 12;	// buckets up to 16 KB of floats are sorted with std::sort
+constexpr int SampleSortMaxBuckets = 256;	// bucket numbers fit in one byte
+constexpr int Oversampling = 16;
+constexpr int SampleSortMaxDepth = 4;
+
+//////////////////////////////////////////////////////////////////////////////////////////////
+// Number of buckets for n elements: a power of 2, such that the buckets are about SampleSortBase
+inline int sampleSortBuckets(size_t n) {
+	return (int)std::clamp<size_t>(std::bit_floor(n/SampleSortBase), 2, SampleSortMaxBuckets);
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////
+// Splitters in a complete binary search tree (Eytzinger layout): node j has the children 2j
+// and 2j + 1, the leaves k..2k - 1 are the buckets. Bucket b holds the elements x with
+// s[b - 1] < x <= s[b].
+template<typename T, typename Compare = std::less<T>>
+class SplitterTree {
+	std::vector<T> m_tree;	// nodes 1..k - 1
+	Compare m_comp;
+	int m_k = 0;
+	int m_log = 0;
+
+	void fill(const std::vector<T>& splitters, size_t& next, int j) {
+		if (j >= m_k) return;
+		fill(splitters, next, 2*j);
+		m_tree[j] = splitters[next++];
+		fill(splitters, next, 2*j + 1);
+	}
+
+public:
+	// draws the sample from a[0..n-1] and builds the tree of k - 1 splitters
+	SplitterTree(const T a[], size_t n, int k, Compare comp = Compare()) : m_tree(k), m_comp(comp), m_k(k), m_log(std::bit_width((unsigned)k) - 1) {
+		std::default_random_engine e((unsigned)n);
+		std::uniform_int_distribution<size_t> dist(0, n - 1);
+		std::vector<T> sample(Oversampling*k);
+		std::vector<T> splitters(k - 1);
+		size_t next = 0;
+
+		for (T& x : sample) x = a[dist(e)];
+		std::sort(sample.begin(), sample.end(), m_comp);
+		for (int i = 0; i < k - 1; i++) splitters[i] = sample[(i + 1)*Oversampling];
+		fill(splitters, next, 1);
+	}
+
+	int buckets() const { return m_k; }
+
+	// log k steps without data-dependent branches
+	int bucket(const T& x) const {
+		int j = 1;
+
+		for (int l = 0; l < m_log; l++) j = 2*j + m_comp(m_tree[j], x);
+		return j - m_k;
+	}
+
+	// classifies x[0..n-1] into b[0..n-1], eight independent searches at a time
+	void classify(const T x[], size_t n, uint8_t b[]) const {
+		constexpr int Batch = 8;
+		size_t i = 0;
+
+		for (; i + Batch <= n; i += Batch) {
+			int j[Batch];
+
+			for (int u = 0; u < Batch; u++) j[u] = 1;
+			for (int l = 0; l < m_log; l++) {
+				for (int u = 0; u < Batch; u++) j[u] = 2*j[u] + m_comp(m_tree[j[u]], x[i + u]);
+			}
+			for (int u = 0; u < Batch; u++) b[i + u] = (uint8_t)(j[u] - m_k);
+		}
+		for (; i < n; i++) b[i] = (uint8_t)bucket(x[i]);
+	}
+};
+
+template<typename T, typename Compare> void sampleSortFrom(T data[], T buf[], size_t n, int depth, Compare comp);
+
+//////////////////////////////////////////////////////////////////////////////////////////////
+// Serial distribution of src[0..n-1] into the buckets in dst; bounds receives the k + 1
+// bucket boundaries. Returns false without touching dst if all elements fall into one bucket
+// (e.g. all equal), because then a further level makes no progress.
+template<typename T, typename Compare>
+bool sampleSortDistribute(const T src[], T dst[], size_t n, std::vector<size_t>& bounds, Compare comp) {
+	const SplitterTree<T, Compare> tree(src, n, sampleSortBuckets(n), comp);
+	const int k = tree.buckets();
+
+	std::vector<uint8_t> oracle(n);
+
+	tree.classify(src, n, oracle.data());
+	bounds.assign(k + 1, 0);
+	for (size_t i = 0; i < n; i++) bounds[oracle[i] + 1]++;
+	if (*std::max_element(bounds.begin(), bounds.end()) == n) return false;
+	for (int b = 0; b < k; b++) bounds[b + 1] += bounds[b];
+
+	std::vector<size_t> pos(bounds.begin(), bounds.end() - 1);
+	for (size_t i = 0; i < n; i++) dst[pos[oracle[i]]++] = src[i];
+	return true;
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////
+// Serial sample sort of src[0..n-1] with the result in dst
+template<typename T, typename Compare>
+void sampleSortTo(T src[], T dst[], size_t n, int depth, Compare comp) {
+	std::vector<size_t> bounds;
+
+	if (n <= SampleSortBase || depth == 0 || !sampleSortDistribute(src, dst, n, bounds, comp)) {
+		std::copy(src, src + n, dst);
+		std::sort(dst, dst + n, comp);
+		return;
+	}
+	for (size_t b = 0; b + 1 < bounds.size(); b++) {
+		sampleSortFrom(dst + bounds[b], src + bounds[b], bounds[b + 1] - bounds[b], depth - 1, comp);
+	}
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////
+// Serial sample sort of data[0..n-1] in place, buf is scratch space of n elements
+template<typename T, typename Compare>
+void sampleSortFrom(T data[], T buf[], size_t n, int depth, Compare comp) {
+	std::vector<size_t> bounds;
+
+	if (n <= SampleSortBase || depth == 0 || !sampleSortDistribute(data, buf, n, bounds, comp)) {
+		std::sort(data, data + n, comp);
+		return;
+	}
+	for (size_t b = 0; b + 1 < bounds.size(); b++) {
+		sampleSortTo(buf + bounds[b], data + bounds[b], bounds[b + 1] - bounds[b], depth - 1, comp);
+	}
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////
+// Parallel sample sort of a[0..n-1] with p threads
+template<typename T, typename Compare = std::less<T>>
+void sampleSort(T a[], size_t n, int p, Compare comp = Compare()) {
+	std::vector<T> buf(n);
+
+	if (p <= 1 || n <= 2*SampleSortBase) {
+		sampleSortFrom(a, buf.data(), n, SampleSortMaxDepth, comp);
+		return;
+	}
+
+	const SplitterTree<T, Compare> tree(a, n, sampleSortBuckets(n), comp);
+	const int k = tree.buckets();
+	std::vector<uint8_t> oracle(n);		// bucket of every element, classified only once
+	std::vector<size_t> offsets(p*k);	// per thread and bucket: count, then scatter position
+	std::vector<size_t> bounds(k + 1);
+
+	#pragma omp parallel num_threads(p) default(none) shared(a, buf, tree, oracle, offsets, bounds, comp) firstprivate(n, k)
+	{
+		const int q = omp_get_num_threads();	// the team may be smaller than p (nested region, thread limit)
+		const int t = omp_get_thread_num();
+		const size_t begin = n*t/q;
+		const size_t end = n*(t + 1)/q;
+		size_t* offset = offsets.data() + t*k;
+
+		tree.classify(a + begin, end - begin, oracle.data() + begin);
+		for (size_t i = begin; i < end; i++) offset[oracle[i]]++;
+		#pragma omp barrier
+
+		#pragma omp single
+		{
+			size_t sum = 0;
+
+			for (int b = 0; b < k; b++) {
+				bounds[b] = sum;
+				for (int u = 0; u < q; u++) {
+					const size_t c = offsets[u*k + b];
+
+					offsets[u*k + b] = sum;
+					sum += c;
+				}
+			}
+			bounds[k] = sum;
+		}
+
+		for (size_t i = begin; i < end; i++) buf[offset[oracle[i]]++] = a[i];
+		#pragma omp barrier
+
+		#pragma omp for schedule(dynamic, 1)
+		for (int b = 0; b < k; b++) {
+			sampleSortTo(buf.data() + bounds[b], a + bounds[b], bounds[b + 1] - bounds[b], SampleSortMaxDepth - 1, comp);
+		}
+	}
+}
@@ -0,0 +1,806 @@
+#pragma once
+
+#include <cassert>
+#include <algorithm>
+#include <atomic>
+#include <bit>
+#include <concepts>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <limits>
+#include <numeric>
+#include <random>
+#include <span>
+#include <type_traits>
+#include <utility>
+#include <vector>
+#include <omp.h>
+#include "radixsort.h"
+#include "samplesort.h"
+
+//////////////////////////////////////////////////////////////////////////////////////////////
+// Generic sorting library
+// All algorithms of this module for any element type T and any strict weak ordering comp
+// (default operator<). The entry points take a std::span; the recursive kernels work on
+// a[left]..a[right] with ptrdiff_t indices, like the float kernels they were derived from.
+// The float entry points in quicksort.cpp and bitonicsort.cpp are instantiations of these
+// templates, except the SIMD bitonic kernels, which stay float-only.
+// Key-based sorting:
+// - parallelSortBy sorts records by a key extractor key(x)
+// - sortPairs sorts keys and moves the payloads alongside (SoA co-sorting)
+// Keys with an order-preserving unsigned image (floats, doubles, integers) are sorted by the
+// radix sort, other keys by the sample sort.
+
+//////////////////////////////////////////////////////////////////////////////////////////////
+// compiler directives
+//#define _RANDOMPIVOT_ // random pivot chosing is too slow
+
+//////////////////////////////////////////////////////////////////////////////////////////////
+// order-preserving unsigned images of arithmetic keys
+inline uint32_t orderedKey(float x) {
+	return radixKey(x);
+}
+
+inline uint64_t orderedKey(double x) {
+	const uint64_t u = std::bit_cast<uint64_t>(x);
+
+	return u ^ ((uint64_t)((int64_t)u >> 63) | 0x8000000000000000ull);
+}
+
+template<std::integral I>
+inline std::make_unsigned_t<I> orderedKey(I x) {
+	using U = std::make_unsigned_t<I>;
+
+	if constexpr (std::is_signed_v<I>) return U((U)x ^ (U(1) << (8*sizeof(I) - 1)));
+	else return x;
+}
+
+template<typename K>
+concept OrderedKey = requires(const K& k) { orderedKey(k); };
+
+//////////////////////////////////////////////////////////////////////////////////////////////
+// comparator of records by the key extractor key(x)
+template<typename KeyFn>
+auto byKey(KeyFn key) {
+	return [key](const auto& x, const auto& y) { return key(x) < key(y); };
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////
+// Quicksort
+////////////////////////////////////////////////////////////////////////////////////////
+// determine median of a[p1], a[p2], and a[p3]
+template<typename T, typename Cmp>
+ptrdiff_t median(const T a[], ptrdiff_t p1, ptrdiff_t p2, ptrdiff_t p3, Cmp comp) {
+	const T& ap1 = a[p1];
+	const T& ap2 = a[p2];
+	const T& ap3 = a[p3];
+
+	if (!comp(ap2, ap1)) {
+		return !comp(ap3, ap2) ? p2 : (!comp(ap3, ap1) ? p3 : p1);
+	} else {
+		return !comp(ap3, ap1) ? p1 : (!comp(ap3, ap2) ? p3 : p2);
+	}
+}
+
+////////////////////////////////////////////////////////////////////////////////////////
+// sorts a[p1], a[p2], and a[p3] in place, so a[p2] is their median
+template<typename T, typename Cmp>
+void sort3(T a[], ptrdiff_t p1, ptrdiff_t p2, ptrdiff_t p3, Cmp comp) {
+	if (comp(a[p2], a[p1])) std::swap(a[p1], a[p2]);
+	if (comp(a[p3], a[p2])) {
+		std::swap(a[p2], a[p3]);
+		if (comp(a[p2], a[p1])) std::swap(a[p1], a[p2]);
+	}
+}
+
+////////////////////////////////////////////////////////////////////////////////////////
+// Hoare partition of a[left]..a[right] around the median of three
+// afterwards a[left]..a[j] <= pivot <= a[i]..a[right] and j < i
+template<typename T, typename Cmp>
+void hoarePartition(T a[], ptrdiff_t left, ptrdiff_t right, ptrdiff_t& i, ptrdiff_t& j, Cmp comp) {
+	// compute pivot
+#ifdef _RANDOMPIVOT_
+	std::default_random_engine e;
+	std::uniform_int_distribution<ptrdiff_t> dist(left, right);
+
+	const ptrdiff_t pivotPos = dist(e);
+#else
+	const ptrdiff_t pivotPos = median(a, left, left + (right - left)/2, right, comp);
+#endif
+	const T pivot = a[pivotPos];
+
+	i = left;
+	j = right;
+	do {
+		while (comp(a[i], pivot)) i++;
+		while (comp(pivot, a[j])) j--;
+		if (i <= j) {
+			std::swap(a[i], a[j]);
+			i++;
+			j--;
+		}
+	} while (i <= j);
+}
+
+////////////////////////////////////////////////////////////////////////////////////////
+// serial quicksort
+// sorts a[left]..a[right]
+template<typename T, typename Cmp>
+void quicksort(T a[], ptrdiff_t left, ptrdiff_t right, Cmp comp) {
+	ptrdiff_t i, j;
+
+	hoarePartition(a, left, right, i, j, comp);
+	if (left < j) quicksort(a, left, j, comp);
+	if (i < right) quicksort(a, i, right, comp);
+}
+
+////////////////////////////////////////////////////////////////////////////////////////
+// BlockQuicksort (Edelkamp, Weiss) with introsort safeguards
+constexpr int OffsetBlock = 128;	// elements per offset buffer
+constexpr int InsertionCutoff = 16;	// smaller ranges are sorted by insertion sort
+
+////////////////////////////////////////////////////////////////////////////////////////
+// insertion sort of a[left]..a[right]
+template<typename T, typename Cmp>
+void insertionSort(T a[], ptrdiff_t left, ptrdiff_t right, Cmp comp) {
+	for (ptrdiff_t i = left + 1; i <= right; i++) {
+		T x = std::move(a[i]);
+		ptrdiff_t j = i - 1;
+
+		while (j >= left && comp(x, a[j])) {
+			a[j + 1] = std::move(a[j]);
+			j--;
+		}
+		a[j + 1] = std::move(x);
+	}
+}
+
+////////////////////////////////////////////////////////////////////////////////////////
+// branchless partition of a[left + 1]..a[right] around the pivot a[left]
+// returns the final position of the pivot
+// A block of OffsetBlock elements is scanned from each end; the offsets of the misplaced
+// elements are written unconditionally and the counter is advanced by the comparison
+// result, so the scan has no data-dependent branches. Then the misplaced elements of both
+// blocks are swapped pairwise. Elements equal to the pivot count as misplaced on both
+// sides, which splits runs of duplicates evenly. The at most two blocks left at the end
+// are partitioned with the classic loop.
+template<typename T, typename Cmp>
+ptrdiff_t blockPartition(T a[], const ptrdiff_t left, const ptrdiff_t right, Cmp comp) {
+	const T pivot = a[left];
+	uint8_t offsetsL[OffsetBlock];
+	uint8_t offsetsR[OffsetBlock];
+	ptrdiff_t l = left + 1, r = right;
+	int numL = 0, numR = 0, startL = 0, startR = 0;
+
+	while (r - l + 1 > 2*OffsetBlock) {
+		if (numL == 0) {
+			startL = 0;
+			for (int i = 0; i < OffsetBlock; i++) {
+				offsetsL[numL] = (uint8_t)i;
+				numL += !comp(a[l + i], pivot);
+			}
+		}
+		if (numR == 0) {
+			startR = 0;
+			for (int i = 0; i < OffsetBlock; i++) {
+				offsetsR[numR] = (uint8_t)i;
+				numR += !comp(pivot, a[r - i]);
+			}
+		}
+
+		const int num = std::min(numL, numR);
+
+		for (int k = 0; k < num; k++) std::swap(a[l + offsetsL[startL + k]], a[r - offsetsR[startR + k]]);
+		numL -= num;
+		numR -= num;
+		startL += num;
+		startR += num;
+		if (numL == 0) l += OffsetBlock;
+		if (numR == 0) r -= OffsetBlock;
+	}
+
+	while (l <= r) {
+		if (comp(a[l], pivot)) {
+			l++;
+		} else if (comp(pivot, a[r])) {
+			r--;
+		} else {
+			std::swap(a[l++], a[r--]);
+		}
+	}
+	std::swap(a[left], a[l - 1]);
+	return l - 1;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////
+// introsort loop: recursion on the smaller part, iteration on the larger part, and
+// heapsort when the depth budget is exhausted
+// The samples of the pivot are sorted in place and the pivot is moved to the left end,
+// so runs keep their order: a reversed range does not leave extreme pivots behind.
+// heapsorted, if given, accumulates the number of elements sorted by the heapsort fallback.
+template<typename T, typename Cmp>
+void introsort(T a[], ptrdiff_t left, ptrdiff_t right, int depth, Cmp comp, size_t* heapsorted = nullptr) {
+	while (right - left + 1 > InsertionCutoff) {
+		if (depth-- == 0) {
+			if (heapsorted) *heapsorted += right - left + 1;
+			std::make_heap(a + left, a + right + 1, comp);
+			std::sort_heap(a + left, a + right + 1, comp);
+			return;
+		}
+
+		// median of three, for large ranges pseudo-median of nine, ends up in a[mid]
+		const ptrdiff_t mid = left + (right - left)/2;
+
+		if (right - left > 128) {
+			const ptrdiff_t s = (right - left)/8;
+
+			sort3(a, left, left + s, left + 2*s, comp);
+			sort3(a, mid - s, mid, mid + s, comp);
+			sort3(a, right - 2*s, right - s, right, comp);
+			sort3(a, left + s, mid, right - s, comp);
+		} else {
+			sort3(a, left, mid, right, comp);
+		}
+		std::swap(a[left], a[mid]);
+
+		const ptrdiff_t split = blockPartition(a, left, right, comp);
+		const ptrdiff_t sizeL = split - left, sizeR = right - split;
+
+		// unbalanced partition: swaps elements at fixed positions to break patterns (pdqsort)
+		if (std::min(sizeL, sizeR) < (right - left + 1)/8) {
+			if (sizeL >= InsertionCutoff) {
+				std::swap(a[left], a[left + sizeL/4]);
+				std::swap(a[split - 1], a[split - sizeL/4]);
+			}
+			if (sizeR >= InsertionCutoff) {
+				std::swap(a[split + 1], a[split + 1 + sizeR/4]);
+				std::swap(a[right], a[right - sizeR/4]);
+			}
+		}
+		if (sizeL < sizeR) {
+			introsort(a, left, split - 1, depth, comp, heapsorted);
+			left = split + 1;
+		} else {
+			introsort(a, split + 1, right, depth, comp, heapsorted);
+			right = split - 1;
+		}
+	}
+	insertionSort(a, left, right, comp);
+}
+
+////////////////////////////////////////////////////////////////////////////////////////
+// serial block quicksort with depth limit 2 log(n)
+// sorts a[left]..a[right]
+template<typename T, typename Cmp>
+void blockQuicksort(T a[], ptrdiff_t left, ptrdiff_t right, Cmp comp, size_t* heapsorted = nullptr) {
+	introsort(a, left, right, 2*(int)std::bit_width((size_t)(right - left + 1)), comp, heapsorted);
+}
+
+////////////////////////////////////////////////////////////////////////////////////////
+// parallel quicksort
+// sorts a[left]..a[right] using p threads
+// The two parts of every partition are sorted by tasks with half of the threads each.
+template<typename T, typename Cmp>
+void parallelQuicksort(T a[], ptrdiff_t left, ptrdiff_t right, int p, Cmp comp) {
+	assert(p > 0);
+	assert(left >= 0 && left <= right);
+
+	// Base case: use serial quicksort if array is small or only one thread available
+	if (p <= 1 || (right - left) <= 1000) {
+		quicksort(a, left, right, comp);
+		return;
+	}
+
+	// Partition the array like in serial quicksort
+	ptrdiff_t i, j;
+	hoarePartition(a, left, right, i, j, comp);
+
+	// Split threads between partitions
+	const int leftThreads = p / 2;
+	const int rightThreads = p - leftThreads;
+
+	// Initialize OpenMP parallel region if we're at the top level
+	#pragma omp parallel num_threads(p) if(p > 1 && omp_get_thread_num() == 0)
+	{
+		#pragma omp single nowait
+		{
+			// Create tasks for recursive calls
+			if (left < j) {
+				#pragma omp task
+				parallelQuicksort(a, left, j, leftThreads, comp);
+			}
+
+			if (i < right) {
+				#pragma omp task
+				parallelQuicksort(a, i, right, rightThreads, comp);
+			}
+
+			#pragma omp taskwait
+		}
+	}
+}
+
+////////////////////////////////////////////////////////////////////////////////////////
+// Parallel in-place block partition (Tsigas-Zhang neutralization)
+constexpr ptrdiff_t PartitionBlock = 4096;		// elements per block
+constexpr ptrdiff_t ParallelPartitionMin = 1 << 16;	// smaller ranges are never partitioned by the team
+constexpr ptrdiff_t TaskCutoff = 1 << 14;		// smaller ranges are sorted without new tasks
+
+// state of one partition shared by the team
+struct BlockPartition {
+	std::atomic<ptrdiff_t> remaining { 0 };		// blocks not yet claimed
+	std::atomic<ptrdiff_t> leftBlocks { 0 };	// blocks claimed from the left end
+	std::atomic<ptrdiff_t> rightBlocks { 0 };	// blocks claimed from the right end
+	std::vector<ptrdiff_t> unfinishedLeft;		// per thread: index of the unfinished left block or -1
+	std::vector<ptrdiff_t> unfinishedRight;		// per thread: index of the unfinished right block or -1
+	ptrdiff_t split = 0;				// first position of the right part
+};
+
+////////////////////////////////////////////////////////////////////////////////////////
+// partitions a[left]..a[right] into elements with goesLeft true and the others
+// must be called by all threads of the team
+// Every thread claims a block from the left end and one from the right end and swaps the
+// misplaced elements of both until one block is neutralized, then it claims the next block
+// on that side. At the end every thread holds at most one unfinished block per side. One
+// thread moves the unfinished blocks next to the unclaimed middle and partitions this
+// remaining region of at most (2p + 1) blocks serially.
+template<typename T, typename Pred>
+void parallelPartition(T a[], const ptrdiff_t left, const ptrdiff_t right, Pred goesLeft, BlockPartition& bp) {
+	constexpr ptrdiff_t B = PartitionBlock;
+	const ptrdiff_t end = right + 1;
+
+	#pragma omp single
+	{
+		bp.remaining = (end - left)/B;
+		bp.leftBlocks = 0;
+		bp.rightBlocks = 0;
+		bp.unfinishedLeft.assign(omp_get_num_threads(), -1);	// the team may be smaller than requested
+		bp.unfinishedRight.assign(omp_get_num_threads(), -1);
+	}
+
+	auto leftBlock = [=](ptrdiff_t b) { return a + left + b*B; };
+	auto rightBlock = [=](ptrdiff_t b) { return a + end - (b + 1)*B; };
+	auto claim = [&bp](std::atomic<ptrdiff_t>& side) -> ptrdiff_t {
+		if (bp.remaining.fetch_sub(1, std::memory_order_relaxed) <= 0) return -1;
+		return side.fetch_add(1, std::memory_order_relaxed);
+	};
+
+	ptrdiff_t li = -1, ri = -1, lpos = 0, rpos = 0;
+	while (true) {
+		if (li < 0) {
+			if ((li = claim(bp.leftBlocks)) < 0) break;
+			lpos = 0;
+		}
+		if (ri < 0) {
+			if ((ri = claim(bp.rightBlocks)) < 0) break;
+			rpos = 0;
+		}
+
+		T* L = leftBlock(li);
+		T* R = rightBlock(ri);
+
+		while (true) {
+			while (lpos < B && goesLeft(L[lpos])) lpos++;
+			while (rpos < B && !goesLeft(R[rpos])) rpos++;
+			if (lpos == B || rpos == B) break;
+			std::swap(L[lpos++], R[rpos++]);
+		}
+		if (lpos == B) li = -1;
+		if (rpos == B) ri = -1;
+	}
+	bp.unfinishedLeft[omp_get_thread_num()] = li;
+	bp.unfinishedRight[omp_get_thread_num()] = ri;
+	#pragma omp barrier
+
+	#pragma omp single
+	{
+		// moves the unfinished blocks of one side to the innermost claimed positions,
+		// returns the number of finished blocks
+		auto gather = [](std::vector<ptrdiff_t>& unfinished, ptrdiff_t claimed, auto block) {
+			std::sort(unfinished.begin(), unfinished.end(), std::greater<ptrdiff_t>());
+
+			ptrdiff_t target = claimed - 1;
+			for (ptrdiff_t u : unfinished) {
+				if (u < 0) break;
+				if (u != target) std::swap_ranges(block(u), block(u) + B, block(target));
+				target--;
+			}
+			return target + 1;
+		};
+		const ptrdiff_t finishedLeft = gather(bp.unfinishedLeft, bp.leftBlocks, leftBlock);
+		const ptrdiff_t finishedRight = gather(bp.unfinishedRight, bp.rightBlocks, rightBlock);
+		T* first = a + left + finishedLeft*B;
+		T* last = a + end - finishedRight*B;
+
+		bp.split = std::partition(first, last, goesLeft) - a;
+	}
+}
+
+////////////////////////////////////////////////////////////////////////////////////////
+// task-based quicksort of a[left]..a[right]
+template<typename T, typename Cmp>
+void quicksortTasks(T a[], ptrdiff_t left, ptrdiff_t right, Cmp comp) {
+	if (right - left < TaskCutoff) {
+		if (left < right) quicksort(a, left, right, comp);
+		return;
+	}
+
+	ptrdiff_t i, j;
+	hoarePartition(a, left, right, i, j, comp);
+
+	#pragma omp task default(none) firstprivate(a, left, j, comp)
+	quicksortTasks(a, left, j, comp);
+	quicksortTasks(a, i, right, comp);
+}
+
+////////////////////////////////////////////////////////////////////////////////////////
+// parallel quicksort with parallel partitioning
+// sorts a[left]..a[right] using p threads
+// Ranges larger than n/p are partitioned by all threads together, one after another, in
+// one parallel region. The remaining ranges are handed off to task-based recursion.
+template<typename T, typename Cmp>
+void parallelQuicksortBlocks(T a[], ptrdiff_t left, ptrdiff_t right, int p, Cmp comp) {
+	assert(p > 0);
+	assert(left >= 0 && left <= right);
+
+	if (p == 1) {
+		quicksort(a, left, right, comp);
+		return;
+	}
+
+	using Range = std::pair<ptrdiff_t, ptrdiff_t>;
+	const ptrdiff_t threshold = std::max(ParallelPartitionMin, (right - left + 1)/p);
+	std::vector<Range> large { { left, right } };
+	std::vector<Range> small;
+	Range range;
+	T pivot {};
+	BlockPartition bp;
+
+	#pragma omp parallel num_threads(p) default(none) shared(a, large, small, range, pivot, bp, comp) firstprivate(threshold)
+	{
+		while (true) {
+			#pragma omp single
+			{
+				range = { 0, -1 };
+				while (!large.empty()) {
+					const Range r = large.back();
+
+					large.pop_back();
+					if (r.second - r.first >= threshold) {
+						range = r;
+						pivot = a[median(a, r.first, r.first + (r.second - r.first)/2, r.second, comp)];
+						break;
+					}
+					small.push_back(r);
+				}
+			}
+
+			const auto [l, r] = range;
+			const T pv = pivot;
+
+			if (l > r) break;
+			parallelPartition(a, l, r, [&pv, &comp](const T& x) { return comp(x, pv); }, bp);
+			if (bp.split == l) {
+				// the pivot is the minimum: the elements equal to it are already in place
+				parallelPartition(a, l, r, [&pv, &comp](const T& x) { return !comp(pv, x); }, bp);
+				#pragma omp single
+				if (bp.split <= r) large.push_back({ bp.split, r });
+			} else {
+				#pragma omp single
+				{
+					large.push_back({ l, bp.split - 1 });
+					large.push_back({ bp.split, r });
+				}
+			}
+		}
+
+		#pragma omp single
+		for (const auto& [l, r] : small) {
+			#pragma omp task default(none) firstprivate(a, l, r, comp)
+			quicksortTasks(a, l, r, comp);
+		}
+	}
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////
+// Bitonic sort for arbitrary n and any element type
+// Same network as the float bitonicSortAnyOMP: the array is the first n elements of a
+// virtual array of length bit_ceil(n) padded with +inf, every merge starts with a flip
+// followed by half-cleaners, and comparators with a virtual partner are skipped. Without
+// SIMD kernels every block of BitonicBlockBytes is sorted by the flip network itself.
+constexpr size_t BitonicBlockBytes = 128 << 10;	// fits in L2
+
+////////////////////////////////////////////////////////////////////////////////////////
+// compare-exchange of lo[i] with hi[i] for i < len: lo takes the smaller element
+template<typename T, typename Cmp>
+void compareExchange(T lo[], T hi[], const ptrdiff_t len, Cmp comp) {
+	for (ptrdiff_t i = 0; i < len; i++) {
+		if (comp(hi[i], lo[i])) std::swap(lo[i], hi[i]);
+	}
+}
+
+////////////////////////////////////////////////////////////////////////////////////////
+// flip step of the block [base, base + s), offsets o in [from, to) of the lower half
+template<typename T, typename Cmp>
+void bitonicFlip(T a[], const ptrdiff_t base, const ptrdiff_t s, const ptrdiff_t n, const ptrdiff_t from, const ptrdiff_t to, Cmp comp) {
+	for (ptrdiff_t o = std::max(from, base + s - n); o < to; o++) {
+		T& x = a[base + o];
+		T& y = a[base + s - 1 - o];
+
+		if (comp(y, x)) std::swap(x, y);
+	}
+}
+
+////////////////////////////////////////////////////////////////////////////////////////
+// half-cleaner with distance bitj on the block [base, base + len), restricted to channels < n
+template<typename T, typename Cmp>
+void bitonicHalfCleaner(T a[], const ptrdiff_t base, const ptrdiff_t len, const ptrdiff_t bitj, const ptrdiff_t n, Cmp comp) {
+	for (ptrdiff_t k = base; k < base + len && k + bitj < n; k += 2*bitj) {
+		compareExchange(a + k, a + k + bitj, std::min(bitj, n - k - bitj), comp);
+	}
+}
+
+////////////////////////////////////////////////////////////////////////////////////////
+// ascending sort of the block [base, base + len), restricted to channels < n
+template<typename T, typename Cmp>
+void bitonicSortAnyBlock(T a[], const ptrdiff_t base, const ptrdiff_t len, const ptrdiff_t n, Cmp comp) {
+	for (ptrdiff_t s = 2; s <= len; s <<= 1) {
+		for (ptrdiff_t b = base; b < std::min(n, base + len); b += s) {
+			bitonicFlip(a, b, s, n, 0, s/2, comp);
+			for (ptrdiff_t bitj = s/4; bitj > 0; bitj >>= 1) bitonicHalfCleaner(a, b, s, bitj, n, comp);
+		}
+	}
+}
+
+////////////////////////////////////////////////////////////////////////////////////////
+// Parallel bitonic sort of a[0..n-1] for arbitrary n
+// p parallel threads
+// The blocks are distributed among the threads; the flip and the half-cleaners with
+// distances >= block are distributed in chunks of half a block.
+template<typename T, typename Cmp>
+void bitonicSort(T a[], const ptrdiff_t n, const int p, Cmp comp) {
+	if (n < 2) return;
+
+	const ptrdiff_t N = (ptrdiff_t)std::bit_ceil((size_t)n);
+	const ptrdiff_t block = std::min(N, (ptrdiff_t)std::bit_floor(std::max<size_t>(2, BitonicBlockBytes/sizeof(T))));
+	const ptrdiff_t chunk = block/2;
+
+	#pragma omp parallel num_threads(p) default(none) shared(a, comp) firstprivate(n, N, block, chunk)
+	{
+		#pragma omp for schedule(static)
+		for (ptrdiff_t base = 0; base < n; base += block) {
+			bitonicSortAnyBlock(a, base, block, n, comp);
+		}
+
+		for (ptrdiff_t s = 2*block; s <= N; s <<= 1) {
+			#pragma omp for schedule(static)
+			for (ptrdiff_t c = 0; c < N/2; c += chunk) {
+				const ptrdiff_t o = c%(s/2);
+
+				bitonicFlip(a, c/(s/2)*s, s, n, o, o + chunk, comp);
+			}
+			for (ptrdiff_t bitj = s/4; bitj >= block; bitj >>= 1) {
+				#pragma omp for schedule(static)
+				for (ptrdiff_t c = 0; c < N/2; c += chunk) {
+					const ptrdiff_t k = c/bitj*2*bitj + c%bitj;
+
+					if (k + bitj < n) compareExchange(a + k, a + k + bitj, std::min(chunk, n - k - bitj), comp);
+				}
+			}
+			#pragma omp for schedule(static)
+			for (ptrdiff_t base = 0; base < n; base += block) {
+				for (ptrdiff_t bitj = block/2; bitj > 0; bitj >>= 1) bitonicHalfCleaner(a, base, block, bitj, n, comp);
+			}
+		}
+	}
+}
+
+////////////////////////////////////////////////////////////////////////////////////////
+// compare-split of nlocal data elements
+// input: the sorted blocks own and partner
+// output: the nlocal smallest (keepSmall) or largest elements of both blocks, sorted, in result
+// Only the kept half is merged: from the front for the small half, from the back for the
+// large half. If the blocks are already split, the own block is copied.
+template<typename T, typename Cmp>
+void compareSplit(const ptrdiff_t nlocal, const T own[], const T partner[], T result[], const bool keepSmall, Cmp comp) {
+	if (keepSmall) {
+		if (!comp(partner[0], own[nlocal - 1])) {
+			std::copy(own, own + nlocal, result);
+			return;
+		}
+		for (ptrdiff_t k = 0, i = 0, j = 0; k < nlocal; k++) {
+			result[k] = !comp(partner[j], own[i]) ? own[i++] : partner[j++];
+		}
+	} else {
+		if (!comp(own[0], partner[nlocal - 1])) {
+			std::copy(own, own + nlocal, result);
+			return;
+		}
+		for (ptrdiff_t k = nlocal - 1, i = nlocal - 1, j = nlocal - 1; k >= 0; k--) {
+			result[k] = comp(partner[j], own[i]) ? own[i--] : partner[j--];
+		}
+	}
+}
+
+////////////////////////////////////////////////////////////////////////////////////////
+// Block-based bitonic sort of a[0..n-1]
+// p blocks, reduced to the largest power of 2 that divides n
+// Every block of n/p elements is sorted and then goes through log(p)(log(p) + 1)/2
+// compare-split steps with its partners. The steps alternate between the array and one
+// buffer of n elements: a block is read with its partner's block from the source and its
+// kept half is written to the destination, so the barrier of one worksharing loop per step
+// suffices. The blocks are distributed over the team, which may be smaller than p.
+template<typename T, typename Cmp>
+void bitonicSortBlocks(T a[], const ptrdiff_t n, int p, Cmp comp) {
+	if (n < 2) return;
+
+	p = (int)std::bit_floor((size_t)std::clamp<ptrdiff_t>(p, 1, n));
+	while (n % p) p >>= 1;
+
+	const ptrdiff_t nlocal = n/p;
+	const int d = std::bit_width((unsigned)p) - 1;
+	std::vector<T> buffer(n);
+
+	#pragma omp parallel num_threads(p) default(none) shared(a, buffer, comp) firstprivate(nlocal, d, p)
+	{
+		T* src = a;
+		T* dst = buffer.data();
+
+		#pragma omp for schedule(static)
+		for (int t = 0; t < p; t++) std::sort(a + t*nlocal, a + (t + 1)*nlocal, comp);
+		for (int i = 0; i < d; i++) {
+			for (int j = i; j >= 0; j--) {
+				#pragma omp for schedule(static)
+				for (int t = 0; t < p; t++) {
+					const int partner = t ^ (1 << j);
+					// ascending in groups of 2^(i + 1) blocks with bit i + 1 of t unset
+					const bool ascending = (t & (2 << i)) == 0;
+
+					compareSplit(nlocal, src + t*nlocal, src + partner*nlocal, dst + t*nlocal, ascending == (t < partner), comp);
+				}
+				std::swap(src, dst);
+			}
+		}
+		if (src != a) {
+			#pragma omp for schedule(static)
+			for (int t = 0; t < p; t++) std::copy(src + t*nlocal, src + (t + 1)*nlocal, a + t*nlocal);
+		}
+	}
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////
+// Span entry points
+template<typename T, typename Cmp = std::less<T>>
+void quicksort(std::span<T> a, Cmp comp = Cmp()) {
+	if (a.size() > 1) quicksort(a.data(), 0, (ptrdiff_t)a.size() - 1, comp);
+}
+
+template<typename T, typename Cmp = std::less<T>>
+void blockQuicksort(std::span<T> a, Cmp comp = Cmp()) {
+	if (a.size() > 1) blockQuicksort(a.data(), 0, (ptrdiff_t)a.size() - 1, comp);
+}
+
+template<typename T, typename Cmp = std::less<T>>
+void parallelQuicksort(std::span<T> a, int p, Cmp comp = Cmp()) {
+	if (a.size() > 1) parallelQuicksort(a.data(), 0, (ptrdiff_t)a.size() - 1, p, comp);
+}
+
+template<typename T, typename Cmp = std::less<T>>
+void parallelQuicksortBlocks(std::span<T> a, int p, Cmp comp = Cmp()) {
+	if (a.size() > 1) parallelQuicksortBlocks(a.data(), 0, (ptrdiff_t)a.size() - 1, p, comp);
+}
+
+template<typename T, typename Cmp = std::less<T>>
+void bitonicSort(std::span<T> a, int p, Cmp comp = Cmp()) {
+	bitonicSort(a.data(), (ptrdiff_t)a.size(), p, comp);
+}
+
+template<typename T, typename Cmp = std::less<T>>
+void bitonicSortBlocks(std::span<T> a, int p, Cmp comp = Cmp()) {
+	bitonicSortBlocks(a.data(), (ptrdiff_t)a.size(), p, comp);
+}
+
+template<typename T, typename Cmp = std::less<T>>
+void sampleSort(std::span<T> a, int p, Cmp comp = Cmp()) {
+	sampleSort(a.data(), a.size(), p, comp);
+}
+
+template<typename T, typename KeyFn>
+void radixSort(std::span<T> a, int p, KeyFn key) {
+	radixSort(a.data(), a.size(), p, key);
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////
+// Parallel sort of a with p threads
+// Arithmetic elements in ascending or descending order are sorted by the radix sort on
+// their order-preserving image (for floats this is the radix sort of radixsort.h), all
+// other element types and orders by the sample sort.
+template<typename T, typename Cmp = std::less<T>>
+void parallelSort(std::span<T> a, int p, Cmp comp = Cmp()) {
+	if constexpr (OrderedKey<T> && (std::is_same_v<Cmp, std::less<T>> || std::is_same_v<Cmp, std::less<>>)) {
+		radixSort(a, p, [](const T& x) { return orderedKey(x); });
+	} else if constexpr (OrderedKey<T> && (std::is_same_v<Cmp, std::greater<T>> || std::is_same_v<Cmp, std::greater<>>)) {
+		radixSort(a, p, [](const T& x) { return decltype(orderedKey(x))(~orderedKey(x)); });
+	} else {
+		sampleSort(a, p, comp);
+	}
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////
+// Parallel sort of the records a by the key extractor key(x) with p threads
+// The records are moved with their keys: for small records this beats sorting indices and
+// permuting afterwards.
+template<typename T, typename KeyFn>
+void parallelSortBy(std::span<T> a, int p, KeyFn key) {
+	using K = std::remove_cvref_t<std::invoke_result_t<KeyFn, const T&>>;
+
+	if constexpr (OrderedKey<K> && std::is_trivially_copyable_v<T>) {
+		radixSort(a, p, [&key](const T& x) { return orderedKey(key(x)); });
+	} else {
+		sampleSort(a, p, byKey(key));
+	}
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////
+// Parallel sort of keys with p threads; values[i] is the payload of keys[i] and is moved
+// alongside (SoA co-sorting)
+// Keys with an order-preserving image of at most 32 bits are packed with their index into
+// 64-bit words image << 32 | index, which are radix sorted: the sort moves 8 bytes per
+// element regardless of the payload and is stable, because the index breaks ties. Wider
+// keys are sorted as (image, index) pairs, other keys as indices by the sample sort. Then
+// keys and values are permuted in parallel.
+template<typename K, typename V>
+void sortPairs(std::span<K> keys, std::span<V> values, int p) {
+	assert(keys.size() == values.size());
+	const size_t n = keys.size();
+	std::vector<K> sortedKeys(n);
+	std::vector<V> sortedValues(n);
+
+	// sorted[i] = old[index(i)] for keys and values
+	auto permute = [&](auto index) {
+		#pragma omp parallel for num_threads(p) schedule(static)
+		for (size_t i = 0; i < n; i++) {
+			const size_t j = index(i);
+
+			sortedKeys[i] = std::move(keys[j]);
+			sortedValues[i] = std::move(values[j]);
+		}
+		#pragma omp parallel for num_threads(p) schedule(static)
+		for (size_t i = 0; i < n; i++) {
+			keys[i] = std::move(sortedKeys[i]);
+			values[i] = std::move(sortedValues[i]);
+		}
+	};
+
+	if constexpr (OrderedKey<K>) {
+		if constexpr (sizeof(orderedKey(std::declval<K>())) <= sizeof(uint32_t)) {
+			if (n <= std::numeric_limits<uint32_t>::max()) {
+				std::vector<uint64_t> words(n);
+
+				#pragma omp parallel for num_threads(p) schedule(static)
+				for (size_t i = 0; i < n; i++) words[i] = (uint64_t)orderedKey(keys[i]) << 32 | i;
+				radixSort(std::span(words), p, [](uint64_t w) { return w; });
+				permute([&words](size_t i) { return (size_t)(uint32_t)words[i]; });
+				return;
+			}
+		}
+
+		struct KeyIndex {
+			uint64_t key;
+			size_t index;
+		};
+		std::vector<KeyIndex> pairs(n);
+
+		#pragma omp parallel for num_threads(p) schedule(static)
+		for (size_t i = 0; i < n; i++) pairs[i] = { (uint64_t)orderedKey(keys[i]), i };
+		radixSort(std::span(pairs), p, [](const KeyIndex& x) { return x.key; });
+		permute([&pairs](size_t i) { return pairs[i].index; });
+	} else {
+		std::vector<size_t> index(n);
+
+		std::iota(index.begin(), index.end(), 0);
+		sampleSort(std::span(index), p, [&keys](size_t i, size_t j) { return keys[i] < keys[j]; });
+		permute([&index](size_t i) { return index[i]; });
+	}
+}
@@ -0,0 +1,168 @@
+#include <omp.h>
+#include <algorithm>
+#include <bit>
+#include <cmath>
+#include <cstdint>
+#include <functional>
+#include <numeric>
+#include <tuple>
+#include <vector>
+#include <iostream>
+#include "Stopwatch.h"
+#include "checkresult.h"
+#include "distributions.h"
+#include "sort.h"
+
+////////////////////////////////////////////////////////////////////////////////////////
+// prototypes
+void quicksort(float a[], ptrdiff_t left, ptrdiff_t right);
+void blockQuicksort(float a[], ptrdiff_t left, ptrdiff_t right);
+void parallelQuicksort(float a[], ptrdiff_t left, ptrdiff_t right, int p);
+void parallelQuicksortBlocks(float a[], ptrdiff_t left, ptrdiff_t right, int p);
+void bitonicSortAnyOMP(float a[], const ptrdiff_t n, const int p);
+
+constexpr int BalanceThreads = 8;	// minimum number of threads in the load balance model
+constexpr ptrdiff_t PivotStatsMin = 64;	// smaller partitions do not count in the pivot statistics
+
+////////////////////////////////////////////////////////////////////////////////////////
+// Quality of the median-of-three pivot in the partitions of quicksort
+struct PivotStats {
+	size_t partitions = 0;	// partitions of at least PivotStatsMin elements
+	size_t badSplits = 0;	// partitions with a smaller part below 1/8 of the range
+	double balance = 0;	// mean size of the smaller part relative to the range, ideal 0.5
+	int maxDepth = 0;	// recursion depth
+	double comparisons = 0;	// comparisons/(n log2 n)
+};
+
+////////////////////////////////////////////////////////////////////////////////////////
+// runs the partitions of quicksort on a copy of data in recursion order with an explicit
+// stack, because the recursion depth is unbounded on bad inputs
+static PivotStats pivotStats(std::vector<float> a) {
+	const ptrdiff_t n = a.size();
+	std::vector<std::tuple<ptrdiff_t, ptrdiff_t, int>> stack { { 0, n - 1, 1 } };
+	PivotStats st;
+	size_t comparisons = 0;
+	const auto less = [&comparisons](float x, float y) { comparisons++; return x < y; };	// also counts the median of three
+
+	if (n < 2) return st;
+	while (!stack.empty()) {
+		const auto [left, right, depth] = stack.back();
+		ptrdiff_t i, j;
+
+		stack.pop_back();
+		hoarePartition(a.data(), left, right, i, j, less);
+
+		const double size = double(right - left + 1);
+		const double smaller = (double)std::min(std::max<ptrdiff_t>(0, j - left + 1), std::max<ptrdiff_t>(0, right - i + 1));
+
+		if (size >= PivotStatsMin) {
+			st.partitions++;
+			st.balance += smaller/size;
+			if (smaller < size/8) st.badSplits++;
+		}
+		st.maxDepth = std::max(st.maxDepth, depth);
+		if (i < right) stack.push_back({ i, right, depth + 1 });
+		if (left < j) stack.push_back({ left, j, depth + 1 });
+	}
+	if (st.partitions > 0) st.balance /= st.partitions;
+	st.comparisons = comparisons/(n*std::log2((double)n));
+	return st;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////
+// Load balance model of parallelQuicksort
+// Replays the recursion of parallelQuicksort serially: every partition is charged to the
+// first thread of its team, the team is split in halves regardless of the part sizes, and
+// a leaf (one thread or at most 1000 elements) is sorted by the first thread of its team
+// while the others idle. Returns the critical path in ms; load receives the work per thread.
+static double quicksortBalance(float a[], ptrdiff_t left, ptrdiff_t right, int p, int thread, std::vector<double>& load) {
+	Stopwatch sw;
+
+	if (p <= 1 || (right - left) <= 1000) {
+		sw.Start();
+		quicksort(a, left, right, std::less<float>());
+		sw.Stop();
+		load[thread] += sw.GetElapsedTimeMilliseconds();
+		return sw.GetElapsedTimeMilliseconds();
+	}
+
+	ptrdiff_t i, j;
+
+	sw.Start();
+	hoarePartition(a, left, right, i, j, std::less<float>());
+	sw.Stop();
+
+	const double tp = sw.GetElapsedTimeMilliseconds();
+	const int leftThreads = p/2;
+	double cl = 0, cr = 0;
+
+	load[thread] += tp;
+	if (left < j) cl = quicksortBalance(a, left, j, leftThreads, thread, load);
+	if (i < right) cr = quicksortBalance(a, i, right, p - leftThreads, thread + leftThreads, load);
+	return tp + std::max(cl, cr);
+}
+
+////////////////////////////////////////////////////////////////////////////////////////
+// Sorting benchmark suite: all sort variants on all input distributions
+void sortBenchmarkTests(size_t n) {
+	std::cout << "\nSort Benchmark Tests" << std::endl;
+	Stopwatch sw;
+	const int p = omp_get_num_procs();
+
+	std::cout << std::endl;
+	std::cout << "n = " << n << std::endl;
+	std::cout << "p = " << p << std::endl;
+
+	const std::pair<const char*, std::function<void(float[], size_t)>> variants[] = {
+		{ "quicksort:", [](float a[], size_t len) { quicksort(a, 0, (ptrdiff_t)len - 1); } },
+		{ "block quicksort:", [](float a[], size_t len) { blockQuicksort(a, 0, (ptrdiff_t)len - 1); } },
+		{ "parallel quicksort:", [p](float a[], size_t len) { parallelQuicksort(a, 0, (ptrdiff_t)len - 1, p); } },
+		{ "parallel quicksort (blocks):", [p](float a[], size_t len) { parallelQuicksortBlocks(a, 0, (ptrdiff_t)len - 1, p); } },
+		{ "bitonic sort:", [p](float a[], size_t len) { bitonicSortAnyOMP(a, (ptrdiff_t)len, p); } },
+		{ "bitonic sort (blocks):", [p](float a[], size_t len) { bitonicSortBlocks(a, (ptrdiff_t)len, p, std::less<float>()); } },
+		{ "parallel sample sort:", [p](float a[], size_t len) { sampleSort(a, len, p); } },
+		{ "parallel radix sort:", [p](float a[], size_t len) { radixSort(a, len, p); } },
+	};
+
+	for (Distribution d : Distributions) {
+		const std::vector<float> data = generateInput(d, n);
+		std::vector<float> sortRef = data;
+		std::vector<float> sort(n);
+
+		std::cout << "\ninput: " << distributionName(d) << std::endl;
+
+		sw.Restart();
+		std::sort(sortRef.begin(), sortRef.end());
+		sw.Stop();
+		const double ts = sw.GetElapsedTimeMilliseconds();
+		check("std::sort:", sortRef.data(), sortRef.data(), ts, ts, n, p);
+
+		for (const auto& [text, sortFn] : variants) {
+			std::copy(data.begin(), data.end(), sort.begin());
+			sw.Restart();
+			sortFn(sort.data(), n);
+			sw.Stop();
+			check(text, sortRef.data(), sort.data(), ts, sw.GetElapsedTimeMilliseconds(), n, p);
+		}
+	}
+
+	// median-of-three pivot and load balance of parallelQuicksort
+	const int q = std::max(p, BalanceThreads);
+
+	std::cout << "\nMedian-of-three pivot of quicksort (log2 n = " << std::bit_width(n) - 1 << ")";
+	std::cout << " and load balance of parallel quicksort (model with " << q << " threads)" << std::endl;
+	std::cout << std::setw(16) << std::left << "input" << std::right << std::setw(8) << "depth" << std::setw(13) << "bad splits" << std::setw(10) << "balance";
+	std::cout << std::setw(14) << "cmp/nlog2n" << std::setw(14) << "max/mean" << std::setw(12) << "E bound" << std::endl;
+	for (Distribution d : Distributions) {
+		std::vector<float> data = generateInput(d, n);
+		const PivotStats st = pivotStats(data);
+		std::vector<double> load(q);
+		const double critical = quicksortBalance(data.data(), 0, (ptrdiff_t)n - 1, q, 0, load);
+		const double total = std::accumulate(load.begin(), load.end(), 0.0);
+		const double imbalance = *std::max_element(load.begin(), load.end())/(total/q);
+
+		std::cout << std::setw(16) << std::left << distributionName(d) << std::right << std::setprecision(2) << std::fixed;
+		std::cout << std::setw(8) << st.maxDepth << std::setw(12) << 100.0*st.badSplits/std::max<size_t>(1, st.partitions) << '%' << std::setw(10) << st.balance;
+		std::cout << std::setw(14) << st.comparisons << std::setw(14) << imbalance << std::setw(12) << total/(q*critical) << std::endl;
+	}
+}
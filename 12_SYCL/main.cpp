@@ -3,13 +3,14 @@
 // SYCL reference manual
 // https://registry.khronos.org/SYCL/specs/sycl-2020/html/sycl-2020.html
 // Windows Command Line
-// icx-cl -O2 -EHsc -Qiopenmp -fsycl -fsycl-targets=nvptx64-nvidia-cuda -I..\Stopwatch main.cpp matrixmult.cpp vectoradd.cpp
+// icx-cl -O2 -EHsc -Qiopenmp -fsycl -fsycl-targets=nvptx64-nvidia-cuda -I..\Stopwatch main.cpp matrixmult.cpp vectoradd.cpp reduction.cpp
 
 //#define DEMO // uncomment this line if you want to run the Codeplay demo sample
 
 #ifndef DEMO
 void vectorAdditionTests();
 void matrixMultiplicationTests();
+void reductionTests();
 #endif
 
 static void demo() {
@@ -62,6 +63,7 @@ int main() {
     demo();
 #else
 	vectorAdditionTests();
-	matrixMultiplicationTests();	
+	matrixMultiplicationTests();
+	reductionTests();
 #endif
 }
@@ -0,0 +1,409 @@
+#include <iostream>
+#include <iomanip>
+#include <algorithm>
+#include <numeric>
+#include <limits>
+#include <execution>
+#include <vector>
+#include <omp.h>
+#include <random>
+#include <sycl/sycl.hpp>
+#include "Stopwatch.h"
+
+constexpr size_t WorkGroupSize = 256;
+
+//////////////////////////////////////////////////////////////////////////////////////////////
+// 3D point of the range query tests in 01_C++ (trivially copyable, usable in kernels)
+struct Point {
+	float x, y, z;
+
+	bool operator==(const Point& p) const {
+		return x == p.x && y == p.y && z == p.z;
+	}
+
+	bool operator<(const Point& p) const {
+		return x < p.x || (x == p.x && (y < p.y || (y == p.y && z < p.z)));
+	}
+
+	bool operator<=(const Point& p) const {
+		return x <= p.x && y <= p.y && z <= p.z;
+	}
+};
+
+//////////////////////////////////////////////////////////////////////////////////////////////
+// Work-group size that the device supports and global range rounded up to a multiple of it
+static sycl::nd_range<1> ndRange(const sycl::queue& q, size_t n) {
+	const size_t wg = std::min(WorkGroupSize, q.get_device().get_info<sycl::info::device::max_work_group_size>());
+
+	return sycl::nd_range<1>((n + wg - 1)/wg*wg, wg);
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////
+// Sequential summation
+static int64_t sumSerial(const std::vector<int>& arr) {
+	int64_t sum = 0;
+
+	for (auto& v : arr) {
+		sum += v;
+	}
+	return sum;
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////
+// Parallel summation with std::reduce
+static int64_t sumParallel(const std::vector<int>& arr) {
+	return std::reduce(std::execution::par, arr.begin(), arr.end(), int64_t(0));
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////
+// Parallel summation with OMP reduction
+static int64_t sumOMP(const std::vector<int>& arr) {
+	int64_t sum = 0;
+
+	#pragma omp parallel for default(none) shared(arr) reduction(+:sum)
+	for (size_t i = 0; i < arr.size(); i++) {
+		sum += arr[i];
+	}
+	return sum;
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////
+// Summation with a SYCL reduction variable: the runtime combines the partial sums
+static int64_t sumSYCL(sycl::queue& q, const std::vector<int>& arr) {
+	int64_t sum = 0;
+	{
+		sycl::buffer aBuf(arr);
+		sycl::buffer<int64_t> sumBuf(&sum, 1);
+
+		q.submit([&](sycl::handler& h) {
+			sycl::accessor aAcc(aBuf, h, sycl::read_only);
+			auto sumRed = sycl::reduction(sumBuf, h, sycl::plus<int64_t>(), sycl::property::reduction::initialize_to_identity());
+
+			h.parallel_for(sycl::range<1>(arr.size()), sumRed, [=](sycl::id<1> i, auto& s) {
+				s += aAcc[i];
+			});
+		});
+	} // the buffer destructor waits for the kernel and copies the sum back
+	return sum;
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////
+// Summation with group algorithms: every work-group reduces its values with reduce_over_group
+// and one work-item per group adds the group sum atomically to the global sum
+static int64_t sumSYCLgroup(sycl::queue& q, const std::vector<int>& arr) {
+	const size_t n = arr.size();
+	int64_t sum = 0;
+	{
+		sycl::buffer aBuf(arr);
+		sycl::buffer<int64_t> sumBuf(&sum, 1);
+
+		q.submit([&](sycl::handler& h) {
+			sycl::accessor aAcc(aBuf, h, sycl::read_only);
+			sycl::accessor sumAcc(sumBuf, h, sycl::read_write);
+
+			h.parallel_for(ndRange(q, n), [=](sycl::nd_item<1> ii) {
+				const size_t i = ii.get_global_id(0);
+				const auto g = ii.get_group();
+				const int64_t s = sycl::reduce_over_group(g, (i < n) ? (int64_t)aAcc[i] : int64_t(0), sycl::plus<int64_t>());
+
+				if (g.leader()) {
+					sycl::atomic_ref<int64_t, sycl::memory_order::relaxed, sycl::memory_scope::device, sycl::access::address_space::global_space> total(sumAcc[0]);
+
+					total.fetch_add(s);
+				}
+			});
+		});
+	}
+	return sum;
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////
+// Sequential search
+static double findSerial(const std::vector<double>& arr) {
+	return *std::max_element(arr.begin(), arr.end());
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////
+// Parallel search with max_element
+static double findParallel(const std::vector<double>& arr) {
+	return *std::max_element(std::execution::par, arr.begin(), arr.end());
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////
+// Parallel search with OMP reduction
+static double findOMP(const std::vector<double>& arr) {
+	double mx = -std::numeric_limits<double>::infinity();
+
+	#pragma omp parallel for default(none) shared(arr) reduction(max:mx)
+	for (size_t i = 0; i < arr.size(); i++) {
+		mx = std::max(mx, arr[i]);
+	}
+	return mx;
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////
+// Search with a SYCL maximum reduction (requires double precision on the device)
+static double findSYCL(sycl::queue& q, const std::vector<double>& arr) {
+	double mx = -std::numeric_limits<double>::infinity();
+	{
+		sycl::buffer aBuf(arr);
+		sycl::buffer<double> mxBuf(&mx, 1);
+
+		q.submit([&](sycl::handler& h) {
+			sycl::accessor aAcc(aBuf, h, sycl::read_only);
+			auto mxRed = sycl::reduction(mxBuf, h, sycl::maximum<double>(), sycl::property::reduction::initialize_to_identity());
+
+			h.parallel_for(sycl::range<1>(arr.size()), mxRed, [=](sycl::id<1> i, auto& m) {
+				m.combine(aAcc[i]);
+			});
+		});
+	}
+	return mx;
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////
+// Sequential range query
+static std::vector<Point> rqSerial(const std::vector<Point>& v, const Point& from, const Point& to) {
+	std::vector<Point> result;
+
+	std::copy_if(v.begin(), v.end(), std::back_inserter(result), [&](const Point& p) {
+		return from <= p && p <= to;
+	});
+	return result;
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////
+// Parallel range query with copy_if
+static std::vector<Point> rqParallel(const std::vector<Point>& v, const Point& from, const Point& to) {
+	std::vector<Point> result(v.size());
+
+	auto last = std::copy_if(std::execution::par, v.begin(), v.end(), result.begin(), [&](const Point& p) {
+		return from <= p && p <= to;
+	});
+	result.resize(last - result.begin());
+	return result;
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////
+// Parallel range query with OMP: thread-local results are appended in a critical section
+static std::vector<Point> rqOMP(const std::vector<Point>& v, const Point& from, const Point& to) {
+	std::vector<Point> result;
+
+	#pragma omp parallel default(none) shared(v, from, to, result)
+	{
+		std::vector<Point> local;
+
+		#pragma omp for nowait
+		for (size_t i = 0; i < v.size(); i++) {
+			if (from <= v[i] && v[i] <= to) local.push_back(v[i]);
+		}
+		#pragma omp critical
+		result.insert(result.end(), local.begin(), local.end());
+	}
+	return result;
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////
+// Range query with stream compaction on the device
+// Every work-item tests one point. An exclusive scan over the work-group gives each hit its
+// position within the group, the group leader reserves space for all hits of the group with
+// one atomic add on a global counter and broadcasts the group's base offset.
+// The order of the groups in the output is not deterministic.
+static std::vector<Point> rqSYCL(sycl::queue& q, const std::vector<Point>& v, const Point& from, const Point& to) {
+	const size_t n = v.size();
+	std::vector<Point> result(n);
+	uint32_t count = 0;
+	{
+		sycl::buffer vBuf(v);
+		sycl::buffer rBuf(result);
+		sycl::buffer<uint32_t> countBuf(&count, 1);
+
+		q.submit([&](sycl::handler& h) {
+			sycl::accessor vAcc(vBuf, h, sycl::read_only);
+			sycl::accessor rAcc(rBuf, h, sycl::write_only, sycl::no_init);
+			sycl::accessor countAcc(countBuf, h, sycl::read_write);
+
+			h.parallel_for(ndRange(q, n), [=](sycl::nd_item<1> ii) {
+				const size_t i = ii.get_global_id(0);
+				const auto g = ii.get_group();
+				const Point p = (i < n) ? vAcc[i] : from;
+				const uint32_t hit = (i < n && from <= p && p <= to) ? 1 : 0;
+
+				// all work-items of the group take part in the group algorithms, also those beyond n
+				const uint32_t pos = sycl::exclusive_scan_over_group(g, hit, sycl::plus<uint32_t>());
+				const uint32_t groupHits = sycl::reduce_over_group(g, hit, sycl::plus<uint32_t>());
+				uint32_t base = 0;
+
+				if (g.leader() && groupHits) {
+					sycl::atomic_ref<uint32_t, sycl::memory_order::relaxed, sycl::memory_scope::device, sycl::access::address_space::global_space> counter(countAcc[0]);
+
+					base = counter.fetch_add(groupHits);
+				}
+				base = sycl::group_broadcast(g, base);
+				if (hit) rAcc[base + pos] = p;
+			});
+		});
+	}
+	result.resize(count);
+	return result;
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////
+// Check and print results
+static void check(const char text[], bool same, size_t size, double ts, double tp) {
+	const double S = ts/tp;
+
+	std::cout << std::setw(40) << std::left << text << size;
+	std::cout << " in " << std::right << std::setw(7) << std::setprecision(2) << std::fixed << tp << " ms, S = " << S << std::endl;
+	std::cout << std::boolalpha << "The two operations produce the same results: " << same << std::endl;
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////
+// Summation, maximum search and range query of 01_C++ with std::execution, OMP and SYCL.
+// The SYCL timings include the transfers between host and device.
+void reductionTests() {
+	std::cout << std::endl << "Reduction and Filter Tests" << std::endl;
+
+	constexpr int N = 10'000'000;
+
+	std::default_random_engine e;
+	Stopwatch sw;
+
+	// Create an exception handler for asynchronous SYCL exceptions
+	auto exception_handler = [](sycl::exception_list e_list) {
+		for (std::exception_ptr const& e : e_list) {
+			try {
+				std::rethrow_exception(e);
+			} catch (std::exception const& e) {
+#if _DEBUG
+				std::cout << "Failure" << std::endl;
+#endif
+				std::terminate();
+			}
+		}
+	};
+
+	auto selector = sycl::default_selector_v; // The default device selector will select the most performant device.
+	//auto selector = sycl::aspect_selector(sycl::aspect::cpu); // uses the CPU as the underlying OpenCL device
+	sycl::queue q(selector, exception_handler);
+
+	std::cout << "SYCL on " << q.get_device().get_info<sycl::info::device::name>() << std::endl;
+
+	// summation (same input as summationTests in 01_C++)
+	{
+		std::vector<int> arr(N);
+
+		std::iota(arr.begin(), arr.end(), 1);
+		std::cout << std::endl << "Summation" << std::endl;
+
+		sw.Start();
+		const int64_t sumS = sumSerial(arr);
+		sw.Stop();
+		const double ts = sw.GetElapsedTimeMilliseconds();
+		std::cout << "Serial on CPU in " << ts << " ms" << std::endl;
+
+		sw.Restart();
+		const int64_t sumP = sumParallel(arr);
+		sw.Stop();
+		check("Parallel reduce on CPU:", sumS == sumP, arr.size(), ts, sw.GetElapsedTimeMilliseconds());
+
+		sw.Restart();
+		const int64_t sumO = sumOMP(arr);
+		sw.Stop();
+		check("OMP reduction on CPU:", sumS == sumO, arr.size(), ts, sw.GetElapsedTimeMilliseconds());
+
+		try {
+			sw.Restart();
+			const int64_t sumR = sumSYCL(q, arr);
+			sw.Stop();
+			check("SYCL reduction:", sumS == sumR, arr.size(), ts, sw.GetElapsedTimeMilliseconds());
+
+			sw.Restart();
+			const int64_t sumG = sumSYCLgroup(q, arr);
+			sw.Stop();
+			check("SYCL group reduction:", sumS == sumG, arr.size(), ts, sw.GetElapsedTimeMilliseconds());
+		} catch (const std::exception& e) {
+			std::cout << "An exception is caught for summation: " << e.what() << std::endl;
+		}
+	}
+
+	// maximum search (same input as findMaximumTests in 01_C++)
+	{
+		std::vector<double> arr(N);
+		std::uniform_real_distribution dist;
+
+		for (size_t i = 0; i < arr.size(); i++) arr[i] = dist(e);
+		std::cout << std::endl << "Maximum search" << std::endl;
+
+		sw.Restart();
+		const double maxS = findSerial(arr);
+		sw.Stop();
+		const double ts = sw.GetElapsedTimeMilliseconds();
+		std::cout << "Serial on CPU in " << ts << " ms" << std::endl;
+
+		sw.Restart();
+		const double maxP = findParallel(arr);
+		sw.Stop();
+		check("Parallel max_element on CPU:", maxS == maxP, arr.size(), ts, sw.GetElapsedTimeMilliseconds());
+
+		sw.Restart();
+		const double maxO = findOMP(arr);
+		sw.Stop();
+		check("OMP reduction on CPU:", maxS == maxO, arr.size(), ts, sw.GetElapsedTimeMilliseconds());
+
+		if (q.get_device().has(sycl::aspect::fp64)) {
+			try {
+				sw.Restart();
+				const double maxR = findSYCL(q, arr);
+				sw.Stop();
+				check("SYCL reduction:", maxS == maxR, arr.size(), ts, sw.GetElapsedTimeMilliseconds());
+			} catch (const std::exception& e) {
+				std::cout << "An exception is caught for maximum search: " << e.what() << std::endl;
+			}
+		} else {
+			std::cout << "SYCL device does not support double precision" << std::endl;
+		}
+	}
+
+	// range query (same input as rangeQueryTests in 01_C++)
+	{
+		std::uniform_real_distribution<float> dist;
+		std::vector<Point> points;
+		const Point from{ dist(e), dist(e), dist(e) };
+		const Point to{ from.x + dist(e), from.y + dist(e), from.z + dist(e) };
+
+		points.reserve(N);
+		for (int i = 0; i < N; i++) points.push_back({ dist(e), dist(e), dist(e) });
+		std::cout << std::endl << "Range query" << std::endl;
+
+		sw.Restart();
+		std::vector<Point> resultS = rqSerial(points, from, to);
+		sw.Stop();
+		const double ts = sw.GetElapsedTimeMilliseconds();
+		std::cout << "Serial on CPU in " << ts << " ms" << std::endl;
+
+		sw.Restart();
+		std::vector<Point> resultP = rqParallel(points, from, to);
+		sw.Stop();
+		check("Parallel copy_if on CPU:", resultS == resultP, resultP.size(), ts, sw.GetElapsedTimeMilliseconds());
+
+		sw.Restart();
+		std::vector<Point> resultO = rqOMP(points, from, to);
+		sw.Stop();
+		const double tO = sw.GetElapsedTimeMilliseconds();
+		std::sort(resultO.begin(), resultO.end());
+		std::sort(resultS.begin(), resultS.end());
+		check("OMP on CPU:", resultS == resultO, resultO.size(), ts, tO);
+
+		try {
+			sw.Restart();
+			std::vector<Point> resultR = rqSYCL(q, points, from, to);
+			sw.Stop();
+			const double tR = sw.GetElapsedTimeMilliseconds();
+			std::sort(resultR.begin(), resultR.end());
+			check("SYCL scan and compaction:", resultS == resultR, resultR.size(), ts, tR);
+		} catch (const std::exception& e) {
+			std::cout << "An exception is caught for range query: " << e.what() << std::endl;
+		}
+	}
+}